@@ -0,0 +1,153 @@
+#ifndef ALIGNED_BUFFER_H
+#define ALIGNED_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+/* A heap array of n values aligned to a cache line (and so to any vector width).
+ * With huge_pages the memory is mapped in 2 MiB pages: explicit huge pages
+ * if the system has some reserved, transparent ones otherwise.
+ * Values are uninitialized, like a std::array member.
+ */
+template <typename T>
+class aligned_buffer
+{
+private:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t huge_page = 2 * 1024 * 1024;
+
+    T * values;
+    std::size_t count;
+    std::size_t mapped; // bytes if it came from mmap, 0 otherwise
+
+    void release()
+    {
+#if defined(__linux__)
+        if(mapped != 0) {
+            munmap(values, mapped);
+        } else {
+            std::free(values);
+        }
+#else
+        std::free(values);
+#endif
+
+        values = nullptr;
+        count = 0;
+        mapped = 0;
+    }
+
+public:
+    aligned_buffer() : values(nullptr), count(0), mapped(0) { }
+
+    aligned_buffer(const std::size_t n, const bool huge_pages) : aligned_buffer()
+    {
+        allocate(n, huge_pages);
+    }
+
+    ~aligned_buffer()
+    {
+        release();
+    }
+
+    aligned_buffer(const aligned_buffer &) = delete;
+    aligned_buffer & operator=(const aligned_buffer &) = delete;
+
+    aligned_buffer(aligned_buffer && other) : values(other.values), count(other.count), mapped(other.mapped)
+    {
+        other.values = nullptr;
+        other.count = 0;
+        other.mapped = 0;
+    }
+
+    aligned_buffer & operator=(aligned_buffer && other)
+    {
+        std::swap(values, other.values);
+        std::swap(count, other.count);
+        std::swap(mapped, other.mapped);
+        return *this;
+    }
+
+
+    void allocate(const std::size_t n, const bool huge_pages)
+    {
+        const std::size_t bytes = std::max<std::size_t>(n * sizeof(T), 1);
+        void * p { nullptr };
+
+        release();
+
+#if defined(__linux__)
+        if(huge_pages) {
+            const std::size_t rounded = (bytes + huge_page - 1) / huge_page * huge_page;
+
+            p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p == MAP_FAILED) {
+                p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(p != MAP_FAILED) {
+                    madvise(p, rounded, MADV_HUGEPAGE);
+                }
+            }
+
+            if(p == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+
+            mapped = rounded;
+        }
+#else
+        (void)huge_pages;
+#endif
+
+        if(p == nullptr && posix_memalign(&p, alignment, bytes) != 0) {
+            throw std::bad_alloc();
+        }
+
+        values = static_cast<T *>(p);
+        count = n;
+    }
+
+
+    inline T * data()
+    {
+        return values;
+    }
+
+    inline const T * data() const
+    {
+        return values;
+    }
+
+    inline T & operator[](const std::size_t i)
+    {
+        return values[i];
+    }
+
+    inline const T & operator[](const std::size_t i) const
+    {
+        return values[i];
+    }
+
+    inline T * begin() { return values; }
+    inline T * end() { return values + count; }
+    inline const T * begin() const { return values; }
+    inline const T * end() const { return values + count; }
+
+    inline std::size_t size() const
+    {
+        return count;
+    }
+
+    inline void fill(const T & v)
+    {
+        std::fill_n(values, count, v);
+    }
+};
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef ASYNC_STEPPER_H
+#define ASYNC_STEPPER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "cell_type.hpp"
+#include "triple_buffer.hpp"
+
+
+/* A copy of the planes x_begin <= x < x_end of a network after `step` steps.
+ * Reads like the network itself, so a slice_renderer can draw it.
+ */
+struct network_frame
+{
+    std::uint64_t step { 0 };
+    bool growing { true };
+    int size_x { 0 };
+    int size_y { 0 };
+    int size_z { 0 };
+    int x_begin { 0 };
+    int x_end { 0 };
+    std::vector<cell_type> types;
+    std::vector<std::uint8_t> activations;
+
+    inline int width() const
+    {
+        return x_end - x_begin;
+    }
+
+    inline bool has_plane(const int ix) const
+    {
+        return ix >= x_begin && ix < x_end;
+    }
+
+    inline std::size_t index(const int iz, const int iy, const int ix) const
+    {
+        return (static_cast<std::size_t>(iz) * size_y + iy) * width() + (ix - x_begin);
+    }
+
+    inline cell_type type(const int iz, const int iy, const int ix) const
+    {
+        return types[index(iz, iy, ix)];
+    }
+
+    inline std::uint8_t activation(const int iz, const int iy, const int ix) const
+    {
+        return activations[index(iz, iy, ix)];
+    }
+
+    /* Copies the planes out of nw, reusing the memory of the last copy.
+     */
+    template <typename Network>
+    void capture(const Network & nw, const std::uint64_t steps, const int begin, const int end)
+    {
+        step = steps;
+        growing = nw.growing();
+        size_x = nw.size_x();
+        size_y = nw.size_y();
+        size_z = nw.size_z();
+        x_begin = begin;
+        x_end = end;
+
+        const std::size_t cells = static_cast<std::size_t>(size_z) * size_y * width();
+        types.resize(cells);
+        activations.resize(cells);
+
+        std::size_t i { 0 };
+        for(int iz=0; iz<size_z; ++iz) {
+            for(int iy=0; iy<size_y; ++iy) {
+                for(int ix=x_begin; ix<x_end; ++ix, ++i) {
+                    types[i] = nw.type(iz, iy, ix);
+                    activations[i] = nw.activation(iz, iy, ix);
+                }
+            }
+        }
+    }
+};
+
+
+/* Steps a network on a thread of its own, as fast as it goes,
+ * and hands copies of it to observers such as a window, recorders or metrics.
+ *
+ * Each observer asks for a range of x-planes (all of them for the full state)
+ * every so many steps and reads the latest copy whenever it is ready for one,
+ * through a triple_buffer: the stepping thread never waits for an observer,
+ * a slow one just skips frames. The network must not be touched
+ * between start() and stop() other than through the observers.
+ */
+template <typename Network>
+class async_stepper
+{
+public:
+    class observer
+    {
+    private:
+        friend class async_stepper;
+
+        triple_buffer<network_frame> frames;
+        // x_begin << 32 | x_end, so the stepping thread never sees half a change
+        std::atomic<std::uint64_t> planes;
+        unsigned long every;
+        int size_x;
+
+        inline static std::uint64_t pack(const int begin, const int end)
+        {
+            return static_cast<std::uint64_t>(begin) << 32 | static_cast<std::uint32_t>(end);
+        }
+
+        inline static void check_planes(const int x_begin, const int x_end, const int size_x)
+        {
+            if(x_begin < 0 || x_end > size_x || x_begin >= x_end) {
+                throw std::invalid_argument("async_stepper: no planes to observe");
+            }
+        }
+
+    public:
+        observer(const int x_begin, const int x_end, const unsigned long every_steps, const int network_size_x) :
+            planes(pack(x_begin, x_end)),
+            every(every_steps),
+            size_x(network_size_x)
+        {
+        }
+
+        /* Asks for other planes from the next copy on, x_begin <= x < x_end
+         * inside the network like for observe().
+         */
+        inline void set_planes(const int x_begin, const int x_end)
+        {
+            check_planes(x_begin, x_end, size_x);
+            planes.store(pack(x_begin, x_end), std::memory_order_relaxed);
+        }
+
+        /* The latest copy, valid until the next call, nullptr before the first.
+         */
+        inline const network_frame * latest()
+        {
+            frames.update();
+            return frames.front();
+        }
+    };
+
+private:
+    Network & nw;
+    std::vector<std::unique_ptr<observer>> observers;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<std::uint64_t> steps;
+
+
+    void publish(observer & o, const std::uint64_t step)
+    {
+        const std::uint64_t planes = o.planes.load(std::memory_order_relaxed);
+        const int begin = static_cast<int>(planes >> 32);
+        const int end = static_cast<int>(planes & 0xffffffff);
+
+        o.frames.back().capture(nw, step, begin, end);
+        o.frames.publish();
+    }
+
+    void run(const std::uint64_t limit)
+    {
+        std::uint64_t step = steps.load(std::memory_order_relaxed);
+
+        for(const std::unique_ptr<observer> & o : observers) {
+            publish(*o, step);
+        }
+
+        while(!stopping.load(std::memory_order_relaxed) && (limit == 0 || step < limit)) {
+            nw.step_ca();
+            steps.store(++step, std::memory_order_relaxed);
+
+            for(const std::unique_ptr<observer> & o : observers) {
+                if(step % o->every == 0) {
+                    publish(*o, step);
+                }
+            }
+        }
+    }
+
+public:
+    explicit async_stepper(Network & network) :
+        nw(network),
+        stopping(false),
+        steps(0)
+    {
+    }
+
+    ~async_stepper()
+    {
+        stop();
+    }
+
+    async_stepper(const async_stepper &) = delete;
+    async_stepper & operator=(const async_stepper &) = delete;
+
+
+    /* A new observer of the planes x_begin <= x < x_end, copied every `every` steps.
+     * Only before start(), each observer is read by one thread.
+     */
+    observer & observe(const int x_begin, const int x_end, const unsigned long every = 1)
+    {
+        if(thread.joinable()) {
+            throw std::logic_error("async_stepper: observe() while running");
+        }
+        observer::check_planes(x_begin, x_end, nw.size_x());
+        if(every == 0) {
+            throw std::invalid_argument("async_stepper: no steps between copies");
+        }
+
+        observers.emplace_back(new observer(x_begin, x_end, every, nw.size_x()));
+        return *observers.back();
+    }
+
+    /* Starts stepping, until stop() or, unless 0, until `limit` steps in all.
+     * Every observer gets a copy of the network as it starts.
+     */
+    void start(const std::uint64_t limit = 0)
+    {
+        if(thread.joinable()) {
+            return;
+        }
+
+        stopping.store(false);
+        thread = std::thread(&async_stepper::run, this, limit);
+    }
+
+    /* Returns once the current step is done.
+     */
+    void stop()
+    {
+        if(!thread.joinable()) {
+            return;
+        }
+
+        stopping.store(true);
+        thread.join();
+    }
+
+    /* Steps done so far, while running a lower bound.
+     */
+    inline std::uint64_t steps_done() const
+    {
+        return steps.load(std::memory_order_relaxed);
+    }
+};
+
+#endif
@@ -0,0 +1,406 @@
+#ifndef BATCH_NETWORK_H
+#define BATCH_NETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "cell_planes.hpp"
+#include "cell_rng.hpp"
+#include "cell_type.hpp"
+#include "grid_extent.hpp"
+#include "growth_kernel.hpp"
+#include "network.hpp"
+#include "signal_kernel.hpp"
+#include "worker_pool.hpp"
+
+
+/* Up to Width independent networks of the same size stepped together.
+ *
+ * The members are interleaved cell by cell: the planes hold Width bytes per
+ * cell, member n at cell i is at i * Width + n. With Width = 32 a cell of
+ * every member is one AVX2 register, so the vector kernels grow and signal
+ * all of them at once (growth_kernel.hpp, signal_kernel.hpp).
+ * Kicking moves whole groups of Width bytes.
+ *
+ * Every member follows the rules of a basic_network<dynamic_extent, Rules>
+ * exactly, with one difference:
+ * the batch keeps growing until all members have converged, and then all
+ * start signaling together. Growth steps on a converged member change
+ * nothing, so each member signals as it would on its own, only possibly a
+ * few steps later; growth_steps(n) says when it converged.
+ */
+template <int Width = 32, typename Rules = codi_rules>
+class batch_network
+{
+    static_assert(Width > 0 && Width <= 64, "members are tracked in a 64 bit mask");
+
+public:
+    static constexpr int width = Width;
+
+    typedef Rules rules_type;
+
+private:
+    typedef basic_network<dynamic_extent, Rules> rules;
+
+    dynamic_extent extent;  // of a member
+    dynamic_extent storage; // Width times as wide in x
+    std::vector<std::uint64_t> seeds;
+    std::vector<unsigned long> converged_after;
+    unsigned long steps_grown;
+    bool changed;
+    bool has_setup_signaling;
+    std::unique_ptr<worker_pool> workers;
+    signal_kernel kernel;
+
+
+    typedef std::array<std::uint8_t *, 6> lane_pointers;
+
+    inline lane_pointers lanes()
+    {
+        return {{
+            grid.iobuf[0].data(), grid.iobuf[1].data(), grid.iobuf[2].data(),
+            grid.iobuf[3].data(), grid.iobuf[4].data(), grid.iobuf[5].data()
+        }};
+    }
+
+    inline std::size_t plane_size() const
+    {
+        return static_cast<std::size_t>(storage.x()) * storage.y();
+    }
+
+    /* Runs kernel(begin, end) over the storage in z-slabs, like network does.
+     */
+    template <typename Kernel>
+    void for_each_slab(Kernel kernel)
+    {
+        if(!workers) {
+            kernel(0, storage.volume());
+            return;
+        }
+
+        workers->run(storage.z(), [&](unsigned, const std::size_t z_begin, const std::size_t z_end) {
+            kernel(z_begin * plane_size(), z_end * plane_size());
+        });
+    }
+
+
+    /* network::kicking with every shift Width times as far,
+     * a cell group moves as a whole.
+     */
+    void kicking()
+    {
+        const std::ptrdiff_t x_stride = Width;
+        const std::ptrdiff_t y_stride = storage.x();
+        const std::ptrdiff_t z_stride = plane_size();
+        const int ny = storage.y();
+        const int nz = storage.z();
+
+        grid.iobuf[0].slide(x_stride);
+        grid.iobuf[1].slide(-x_stride);
+        grid.iobuf[2].slide(y_stride);
+        grid.iobuf[3].slide(-y_stride);
+        grid.iobuf[4].slide(z_stride);
+        grid.iobuf[5].slide(-z_stride);
+
+        const lane_pointers io = lanes();
+
+        for(int iz=0; iz<nz; ++iz) {
+            for(int iy=0; iy<ny; ++iy) {
+                const std::size_t row = iz * z_stride + iy * y_stride;
+
+                std::fill_n(io[0] + row + y_stride - x_stride, x_stride, 0);
+                std::fill_n(io[1] + row, x_stride, 0);
+            }
+
+            std::fill_n(io[2] + iz * z_stride + (ny - 1) * y_stride, y_stride, 0);
+            std::fill_n(io[3] + iz * z_stride, y_stride, 0);
+        }
+
+        std::fill_n(io[4] + (nz - 1) * z_stride, z_stride, 0);
+        std::fill_n(io[5], z_stride, 0);
+    }
+
+
+    /* network::grow_cells on every member, returns the members that grew.
+     * The vector kernels take whole cells at a time, the scalar rules the rest.
+     */
+    std::uint64_t grow_cells(const std::size_t begin, const std::size_t end)
+    {
+        const lane_pointers io = lanes();
+        const growth_planes planes { grid.type.data(), grid.chromo.data(), grid.gate.data(), io };
+        std::array<std::uint8_t, Width> grew {{ }};
+        std::uint64_t grown { 0 };
+
+        const std::size_t rest = grow_cells_vector(kernel, planes, begin, end, grew.data(), Width);
+
+        for(int n=0; n<Width; ++n) {
+            if(grew[n] != 0) {
+                grown |= std::uint64_t { 1 } << n;
+            }
+        }
+
+        for(std::size_t i=rest; i<end; ++i) {
+            cell_type type = grid.type[i];
+
+            if(type == BLANK) {
+                const std::array<std::uint8_t, 6> in {{ io[0][i], io[1][i], io[2][i], io[3][i], io[4][i], io[5][i] }};
+                type = rules::grow_blank(in, grid.chromo[i], grid.gate[i]);
+
+                if(type != BLANK) {
+                    grown |= std::uint64_t { 1 } << (i % Width);
+                    grid.type[i] = type;
+                }
+            }
+
+            for(int d=0; d<6; ++d) {
+                io[d][i] = rules::growth_output(type, grid.chromo[i], grid.gate[i], d);
+            }
+        }
+
+        return grown;
+    }
+
+    void growth_step()
+    {
+        std::atomic<std::uint64_t> grown { 0 };
+
+        for_each_slab([&](const std::size_t begin, const std::size_t end) {
+            grown.fetch_or(grow_cells(begin, end));
+        });
+
+        ++steps_grown;
+        for(std::size_t n=0; n<seeds.size(); ++n) {
+            if(converged_after[n] == 0 && (grown & (std::uint64_t { 1 } << n)) == 0) {
+                converged_after[n] = steps_grown;
+            }
+        }
+
+        changed = grown != 0;
+        kicking();
+    }
+
+
+    void setup_signaling()
+    {
+        has_setup_signaling = true;
+
+        grid.activation.fill(0);
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].fill(0);
+        }
+
+        for(std::size_t n=0; n<seeds.size(); ++n) {
+            const cell_rng rng(seeds[n]);
+
+            for(int iz=0; iz<extent.z(); ++iz) {
+                for(int iy=0; iy<extent.y(); ++iy) {
+                    for(int ix=0; ix<extent.x(); ++ix) {
+                        const std::size_t i = index(n, iz, iy, ix);
+
+                        if(grid.type[i] == NEURON) {
+                            grid.activation[i] = rules::initial_activation(rng, iz, iy, ix);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void signal_step()
+    {
+        const signal_planes planes { grid.type.data(), grid.gate.data(), grid.activation.data(), lanes() };
+
+        for_each_slab([&](const std::size_t begin, const std::size_t end) {
+            signal_cells<Rules>(kernel, planes, begin, end);
+        });
+
+        kicking();
+    }
+
+
+public:
+    cell_planes<dynamic_extent> grid;
+
+    /* One member per seed, each the network basic_network<dynamic_extent, Rules>(e, seed) would be.
+     * Lanes without a seed stay empty.
+     */
+    batch_network(const dynamic_extent & e, const std::vector<std::uint64_t> & member_seeds) :
+        extent(e),
+        storage(e.x() * Width, e.y(), e.z(), e.huge_pages),
+        seeds(member_seeds),
+        converged_after(member_seeds.size(), 0),
+        steps_grown(0),
+        changed(true),
+        has_setup_signaling(false),
+        kernel(best_signal_kernel()),
+        grid(storage)
+    {
+        if(seeds.size() > static_cast<std::size_t>(Width)) {
+            throw std::invalid_argument("batch_network: more seeds than members");
+        }
+
+        grid.type.fill(BLANK);
+        grid.activation.fill(0);
+        grid.gate.fill(0);
+        grid.chromo.fill(0);
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].fill(0);
+        }
+
+        std::vector<std::uint8_t> row(extent.x());
+
+        for(std::size_t n=0; n<seeds.size(); ++n) {
+            const cell_rng rng(seeds[n]);
+
+            for(int iz=0; iz<extent.z(); ++iz) {
+                for(int iy=0; iy<extent.y(); ++iy) {
+                    rules::initial_chromo_row(rng, iz, iy, extent.x(), row.data());
+
+                    for(int ix=0; ix<extent.x(); ++ix) {
+                        grid.chromo[index(n, iz, iy, ix)] = row[ix];
+                    }
+                }
+            }
+        }
+    }
+
+
+    inline std::size_t members() const
+    {
+        return seeds.size();
+    }
+
+    inline int size_x() const { return extent.x(); }
+    inline int size_y() const { return extent.y(); }
+    inline int size_z() const { return extent.z(); }
+
+    /* Cells of one member.
+     */
+    inline std::size_t volume() const
+    {
+        return extent.volume();
+    }
+
+    inline std::size_t index(const std::size_t member, const int iz, const int iy, const int ix) const
+    {
+        return ((static_cast<std::size_t>(iz) * extent.y() + iy) * extent.x() + ix) * Width + member;
+    }
+
+    inline std::uint64_t seed(const std::size_t member) const
+    {
+        return seeds[member];
+    }
+
+
+    /* Replaces the chromosome of a member, e.g. with one from a genome.
+     * Only before the first step.
+     */
+    void set_chromo(const std::size_t member, const std::uint8_t * chromo)
+    {
+        if(steps_grown != 0 || has_setup_signaling) {
+            throw std::logic_error("batch_network: chromosomes can only be set before the first step");
+        }
+
+        for(std::size_t i=0; i<volume(); ++i) {
+            grid.chromo[i * Width + member] = chromo[i];
+        }
+    }
+
+    /* Copies a member into nw, a network of the same size, in the state
+     * it would have on its own.
+     */
+    template <typename Network>
+    void store(const std::size_t member, Network & nw) const
+    {
+        if(nw.size_x() != size_x() || nw.size_y() != size_y() || nw.size_z() != size_z()) {
+            throw std::invalid_argument("batch_network: the network has another size");
+        }
+
+        for(std::size_t i=0; i<volume(); ++i) {
+            const std::size_t j = i * Width + member;
+
+            nw.grid.type[i] = grid.type[j];
+            nw.grid.activation[i] = grid.activation[j];
+            nw.grid.chromo[i] = grid.chromo[j];
+            nw.grid.gate[i] = grid.gate[j];
+            for(int d=0; d<6; ++d) {
+                nw.grid.iobuf[d][i] = grid.iobuf[d][j];
+            }
+        }
+
+        nw.restore_state(seeds[member], converged_after[member] == 0, has_setup_signaling);
+    }
+
+
+    inline cell_type type(const std::size_t member, const int iz, const int iy, const int ix) const
+    {
+        return grid.type[index(member, iz, iy, ix)];
+    }
+
+    inline std::uint8_t activation(const std::size_t member, const int iz, const int iy, const int ix) const
+    {
+        return grid.activation[index(member, iz, iy, ix)];
+    }
+
+
+    void set_threads(const unsigned threads)
+    {
+        workers.reset(threads > 1 ? new worker_pool(threads) : nullptr);
+    }
+
+    inline unsigned threads() const
+    {
+        return workers ? workers->size() : 1;
+    }
+
+    inline void set_signal_kernel(const signal_kernel k)
+    {
+        kernel = k;
+    }
+
+
+    /* true until every member has converged.
+     */
+    inline bool growing() const
+    {
+        return changed;
+    }
+
+    /* The growth steps member needed on its own, 0 while it still grows.
+     */
+    inline unsigned long growth_steps(const std::size_t member) const
+    {
+        return converged_after[member];
+    }
+
+
+    /* Once every member has converged, set up the signaling state now
+     * instead of lazily in the next step_ca().
+     */
+    void prepare_signaling()
+    {
+        if(!changed && !has_setup_signaling) {
+            setup_signaling();
+        }
+    }
+
+    void step_ca()
+    {
+        if(changed) {
+            growth_step();
+        } else {
+            if(!has_setup_signaling) {
+                setup_signaling();
+            }
+
+            signal_step();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network.hpp"
+
+
+/* Times the phases of a step one by one, across grid sizes, neuron
+ * densities and seeds, for both growth engines, and end to end
+ * (grow until converged, then signal), as well as a reset of the
+ * network in its memory. Built with the instrumentation
+ * on (see Makefile), which times each phase from inside the network.
+ *
+ * One row per scenario and phase, as CSV or JSON lines, so runs
+ * from different commits can be diffed.
+ */
+
+
+struct bench_options
+{
+    std::vector<std::array<int, 3>> sizes {{ {{ 32, 32, 32 }}, {{ 64, 64, 64 }}, {{ 128, 128, 128 }} }};
+    std::vector<double> densities { 1, 0.5, 0.25 };
+    std::vector<std::uint64_t> seeds { 1, 2, 3 };
+    unsigned long signal_steps { 200 };
+    int tile_steps { 1 };
+    unsigned threads { std::thread::hardware_concurrency() };
+    signal_kernel kernel { best_signal_kernel() };
+    std::string format { "csv" };
+    std::string output;
+};
+
+
+void usage(const char * name)
+{
+    std::cerr
+        << "usage: " << name << " [options]\n"
+        << "  --sizes LIST          comma separated N or XxYxZ (default 32,64,128)\n"
+        << "  --densities LIST      fraction of neuron seeds kept (default 1,0.5,0.25)\n"
+        << "  --seeds LIST          (default 1,2,3)\n"
+        << "  --signal-steps N      signaling steps per scenario (default 200)\n"
+        << "  --tile-steps K        fuse K signaling steps into one pass (default 1)\n"
+        << "  --threads N           worker threads (default all cores)\n"
+        << "  --kernel scalar|sse2|avx2  signaling kernel (default the best the cpu has)\n"
+        << "  --format csv|json     (default csv)\n"
+        << "  --output FILE         write the rows to FILE instead of stdout\n";
+}
+
+
+std::vector<std::string> split(const std::string & s)
+{
+    std::vector<std::string> parts;
+    std::stringstream in(s);
+    std::string part;
+
+    while(std::getline(in, part, ',')) {
+        parts.push_back(part);
+    }
+
+    return parts;
+}
+
+bool parse_size(const std::string & s, std::array<int, 3> & size)
+{
+    char x1 { 0 }, x2 { 0 }, rest { 0 };
+
+    if(std::sscanf(s.c_str(), "%d%c%d%c%d%c", &size[0], &x1, &size[1], &x2, &size[2], &rest) == 5) {
+        return x1 == 'x' && x2 == 'x' && size[0] > 0 && size[1] > 0 && size[2] > 0;
+    }
+
+    if(std::sscanf(s.c_str(), "%d%c", &size[0], &rest) == 1) {
+        size[1] = size[2] = size[0];
+        return size[0] > 0;
+    }
+
+    return false;
+}
+
+bool parse_options(int argc, char ** argv, bench_options & o)
+{
+    for(int i=1; i+1<argc; i+=2) {
+        const std::string arg { argv[i] };
+        const std::string value { argv[i + 1] };
+
+        if(arg == "--sizes") {
+            o.sizes.clear();
+            for(const std::string & s : split(value)) {
+                std::array<int, 3> size;
+                if(!parse_size(s, size)) {
+                    return false;
+                }
+                o.sizes.push_back(size);
+            }
+        } else if(arg == "--densities") {
+            o.densities.clear();
+            for(const std::string & s : split(value)) {
+                o.densities.push_back(std::strtod(s.c_str(), nullptr));
+            }
+        } else if(arg == "--seeds") {
+            o.seeds.clear();
+            for(const std::string & s : split(value)) {
+                o.seeds.push_back(std::strtoull(s.c_str(), nullptr, 0));
+            }
+        } else if(arg == "--signal-steps") {
+            o.signal_steps = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--tile-steps") {
+            o.tile_steps = std::strtol(value.c_str(), nullptr, 0);
+        } else if(arg == "--threads") {
+            o.threads = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--kernel" && value == "scalar") {
+            o.kernel = signal_kernel::SCALAR;
+        } else if(arg == "--kernel" && value == "sse2") {
+            o.kernel = signal_kernel::SSE2;
+        } else if(arg == "--kernel" && value == "avx2") {
+            o.kernel = signal_kernel::AVX2;
+        } else if(arg == "--format" && (value == "csv" || value == "json")) {
+            o.format = value;
+        } else if(arg == "--output") {
+            o.output = value;
+        } else {
+            return false;
+        }
+    }
+
+    return argc % 2 == 1 && !o.sizes.empty() && !o.densities.empty() && !o.seeds.empty();
+}
+
+
+inline const char * kernel_name(const signal_kernel k)
+{
+    switch(k) {
+        case signal_kernel::SCALAR: return "scalar";
+        case signal_kernel::SSE2:   return "sse2";
+        case signal_kernel::AVX2:   return "avx2";
+    }
+
+    return "";
+}
+
+
+struct scenario
+{
+    std::array<int, 3> size;
+    double density;
+    std::uint64_t seed;
+    growth_engine engine;
+};
+
+struct bench_row
+{
+    std::string phase;
+    std::uint64_t calls;
+    double seconds;
+    double cells;          // cells updated per call
+    double bytes_per_cell; // plane bytes read and written per updated cell, < 0 if unknown
+};
+
+
+/* Drops neuron seeds until about density of them are left.
+ */
+void thin_neurons(dynamic_network & nw, const double density, const std::uint64_t seed)
+{
+    const cell_rng rng(splitmix64(seed));
+    const std::uint32_t keep = (density >= 1) ? 0xffffffff : static_cast<std::uint32_t>(density * 4294967296.0);
+
+    for(int iz=0; iz<nw.size_z(); ++iz) {
+        for(int iy=0; iy<nw.size_y(); ++iy) {
+            for(int ix=0; ix<nw.size_x(); ++ix) {
+                std::uint8_t & chromo = nw.grid.chromo[nw.index(iz, iy, ix)];
+
+                if(cell::is_neuronseed(chromo) && (rng(cell_rng::NEURON_SEED, iz, iy, ix) >> 32) >= keep) {
+                    chromo &= ~192;
+                }
+            }
+        }
+    }
+}
+
+
+std::vector<bench_row> run(const bench_options & o, const scenario & s, std::size_t & live)
+{
+    dynamic_network nw(dynamic_extent(s.size[0], s.size[1], s.size[2]), s.seed);
+    nw.set_threads(o.threads);
+    nw.set_signal_kernel(o.kernel);
+    nw.set_growth_engine(s.engine);
+    nw.set_temporal_tiling(o.tile_steps);
+
+    // building it again in place, on the workers
+    const auto reset_start = std::chrono::steady_clock::now();
+    nw.reset(s.seed);
+    const double reset_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - reset_start).count();
+
+    thin_neurons(nw, s.density, s.seed);
+
+    const double volume = nw.volume();
+    const auto start = std::chrono::steady_clock::now();
+
+    unsigned long steps { 0 };
+    while(nw.growing()) {
+        nw.step_ca();
+        ++steps;
+    }
+
+    nw.prepare_signaling();
+    nw.step_ca(o.signal_steps);
+
+    const double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const instrumentation & stats = nw.stats();
+
+    live = 0;
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        live += (nw.grid.type[i] != BLANK) ? 1 : 0;
+    }
+
+    // the lanes of the faces that came in from outside
+    const double faces = 2.0 * (static_cast<double>(s.size[0]) * s.size[1] + static_cast<double>(s.size[1]) * s.size[2]
+                                + static_cast<double>(s.size[0]) * s.size[2]);
+
+    std::vector<bench_row> rows;
+    // writes chromo, type, activation, gate and the lanes
+    rows.push_back(bench_row { "reset", 1, reset_seconds, volume, 10 });
+    // a full scan reads type, chromo, gate and the six lanes and writes the lanes
+    rows.push_back(bench_row { "growth", stats.phase_calls(step_phase::GROWTH), stats.phase_seconds(step_phase::GROWTH),
+                               volume, (s.engine == growth_engine::FULL_SCAN) ? 15.0 : -1.0 });
+    rows.push_back(bench_row { "kick", stats.phase_calls(step_phase::KICK), stats.phase_seconds(step_phase::KICK),
+                               volume, faces / volume });
+    // reads type, activation and the lanes, writes activation and the lanes
+    rows.push_back(bench_row { "setup_signaling", stats.phase_calls(step_phase::SETUP_SIGNALING),
+                               stats.phase_seconds(step_phase::SETUP_SIGNALING), volume, 8 });
+    // reads type, gate, activation and the lanes, writes activation and the lanes;
+    // a call of fused steps updates every cell that often, from the cache
+    const std::uint64_t signal_calls = stats.phase_calls(step_phase::SIGNAL);
+    const bool fused = signal_calls < o.signal_steps;
+    rows.push_back(bench_row { "signal", signal_calls, stats.phase_seconds(step_phase::SIGNAL),
+                               fused ? volume * o.signal_steps / signal_calls : volume, fused ? -1.0 : 16.0 });
+    rows.push_back(bench_row { "grow_then_signal", steps + o.signal_steps, total, volume, -1 });
+
+    return rows;
+}
+
+
+void write_row(std::ostream & out, const bench_options & o, const scenario & s, const std::size_t live, const bench_row & r)
+{
+    const double per_call = (r.calls > 0) ? r.seconds / r.calls : 0;
+    const double updates = (r.seconds > 0) ? r.cells * r.calls / r.seconds : 0;
+    const char * engine = (s.engine == growth_engine::FULL_SCAN) ? "full" : "frontier";
+
+    if(o.format == "json") {
+        out << "{\"phase\":\"" << r.phase << "\",\"size_x\":" << s.size[0] << ",\"size_y\":" << s.size[1]
+            << ",\"size_z\":" << s.size[2] << ",\"density\":" << s.density << ",\"seed\":" << s.seed
+            << ",\"growth\":\"" << engine << "\",\"kernel\":\"" << kernel_name(o.kernel) << "\",\"threads\":" << o.threads
+            << ",\"tile_steps\":" << o.tile_steps << ",\"live_cells\":" << live << ",\"calls\":" << r.calls << ",\"seconds\":" << r.seconds
+            << ",\"seconds_per_call\":" << per_call << ",\"cell_updates_per_sec\":" << updates
+            << ",\"bytes_per_cell\":";
+        if(r.bytes_per_cell < 0) {
+            out << "null,\"bytes_per_sec\":null}\n";
+        } else {
+            out << r.bytes_per_cell << ",\"bytes_per_sec\":" << r.bytes_per_cell * updates << "}\n";
+        }
+        return;
+    }
+
+    out << r.phase << ',' << s.size[0] << ',' << s.size[1] << ',' << s.size[2] << ',' << s.density << ',' << s.seed << ','
+        << engine << ',' << kernel_name(o.kernel) << ',' << o.threads << ',' << o.tile_steps << ',' << live << ','
+        << r.calls << ',' << r.seconds << ',' << per_call << ',' << updates << ',';
+    if(r.bytes_per_cell >= 0) {
+        out << r.bytes_per_cell << ',' << r.bytes_per_cell * updates;
+    } else {
+        out << ',';
+    }
+    out << '\n';
+}
+
+
+int main(int argc, char ** argv)
+{
+    bench_options o;
+
+    if(!parse_options(argc, argv, o)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream file;
+    if(!o.output.empty()) {
+        file.open(o.output);
+        if(!file) {
+            std::cerr << "could not write " << o.output << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostream & out = o.output.empty() ? std::cout : file;
+
+    if(o.format == "csv") {
+        out << "phase,size_x,size_y,size_z,density,seed,growth,kernel,threads,tile_steps,live_cells,"
+            << "calls,seconds,seconds_per_call,cell_updates_per_sec,bytes_per_cell,bytes_per_sec\n";
+    }
+
+    for(const std::array<int, 3> & size : o.sizes) {
+        for(const double density : o.densities) {
+            for(const std::uint64_t seed : o.seeds) {
+                for(const growth_engine engine : { growth_engine::FULL_SCAN, growth_engine::FRONTIER }) {
+                    const scenario s { size, density, seed, engine };
+                    std::size_t live { 0 };
+
+                    for(const bench_row & r : run(o, s, live)) {
+                        write_row(out, o, s, live, r);
+                    }
+                    out.flush();
+                }
+            }
+        }
+    }
+
+    return 0;
+}
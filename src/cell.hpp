@@ -38,11 +38,14 @@ public:
 
 
 
-    cell() : 
+    /* A blank cell with the given chromo; random chromosomes come from
+     * cell_rng, see network::initial_chromo.
+     */
+    explicit cell(const std::uint8_t c = 0) :
         iobuf({{0, 0, 0, 0, 0, 0}}),
         type(cell_type::BLANK), 
         activation(0), 
-        chromo(two_five_six_rng(rng_gen)), 
+        chromo(c), 
         gate(0)
         { }
 
@@ -62,6 +65,11 @@ public:
     /* see if it is a neuronseed (in bit ..7,8 of chromo) 
      */
     inline bool is_neuronseed() const
+    {
+        return is_neuronseed(chromo);
+    }
+
+    inline static bool is_neuronseed(const std::uint8_t chromo)
     {
         return (chromo >> 6) == NEURONSEED;
     }
@@ -71,6 +79,11 @@ public:
      * read chromo bitmask note above
     */
     inline std::uint8_t chromo_dir_choice(const int shift, const std::uint8_t a, const std::uint8_t b) const
+    {
+        return chromo_dir_choice(chromo, shift, a, b);
+    }
+
+    inline static std::uint8_t chromo_dir_choice(const std::uint8_t chromo, const int shift, const std::uint8_t a, const std::uint8_t b)
     {
         return (((chromo >> shift) & 1) != 0) ? a : b;
     }
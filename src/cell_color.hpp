@@ -1,7 +1,9 @@
 #ifndef CELL_COLOR_H
 #define CELL_COLOR_H
 
+#include <array>
 #include <cstdint>
+#include "cell_type.hpp"
 
 enum class cell_color : std::uint8_t {
     DEFAULT,
@@ -12,4 +14,40 @@ enum class cell_color : std::uint8_t {
     DENDRITE
 };
 
+constexpr int cell_colors = 6;
+
+
+/* What a cell shows: its type, and for axons and dendrites whether they
+ * carry a signal. Blank cells show the background.
+ */
+inline cell_color color_of(const cell_type type, const std::uint8_t activation)
+{
+    // by type (BLANK, NEURON, AXON, -, DENDRITE), then whether the activation is 0 or not
+    static const cell_color colors[5][2] = {
+        { cell_color::DEFAULT,  cell_color::DEFAULT },
+        { cell_color::NEURON,   cell_color::NEURON },
+        { cell_color::AXON,     cell_color::AXON_SIGNAL },
+        { cell_color::DEFAULT,  cell_color::DEFAULT },
+        { cell_color::DENDRITE, cell_color::DENDRITE_SIGNAL }
+    };
+
+    return colors[type][activation != 0 ? 1 : 0];
+}
+
+/* RGBA of each cell_color.
+ */
+inline const std::array<std::uint8_t, 4> & color_rgba(const cell_color c)
+{
+    static const std::array<std::uint8_t, 4> palette[cell_colors] = {
+        {{ 60,  60,  60,  255 }}, // DEFAULT
+        {{ 255, 0,   200, 255 }}, // AXON_SIGNAL
+        {{ 0,   255, 200, 255 }}, // DENDRITE_SIGNAL
+        {{ 217, 184, 0,   255 }}, // NEURON
+        {{ 150, 50,  150, 150 }}, // AXON
+        {{ 50,  150, 150, 150 }}  // DENDRITE
+    };
+
+    return palette[static_cast<int>(c)];
+}
+
 #endif
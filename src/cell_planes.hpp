@@ -0,0 +1,120 @@
+#ifndef CELL_PLANES_H
+#define CELL_PLANES_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "cell_type.hpp"
+#include "grid_extent.hpp"
+
+
+/* One iobuf direction of the grid.
+ * The visible plane is a window into a buffer twice the size of the grid,
+ * so shifting every value by a whole stride (what kicking does) only moves
+ * the window. The data is copied back to the other end of the buffer once
+ * the window runs out of room, i.e. at most once every volume/stride slides.
+ */
+template <typename Extent>
+class lane_plane
+{
+private:
+    typename Extent::template buffer<std::uint8_t, 2> storage;
+    std::size_t offset;
+    std::size_t volume;
+
+public:
+    lane_plane() : offset(0), volume(0) { }
+
+    void allocate(const Extent & extent)
+    {
+        extent.template allocate<std::uint8_t, 2>(storage);
+        offset = 0;
+        volume = extent.volume();
+    }
+
+    inline std::uint8_t * data()
+    {
+        return storage.data() + offset;
+    }
+
+    inline const std::uint8_t * data() const
+    {
+        return storage.data() + offset;
+    }
+
+    inline std::uint8_t & operator[](const std::size_t i)
+    {
+        return storage[offset + i];
+    }
+
+    inline std::uint8_t operator[](const std::size_t i) const
+    {
+        return storage[offset + i];
+    }
+
+    inline void fill(const std::uint8_t v)
+    {
+        std::fill_n(data(), volume, v);
+    }
+
+    /* afterwards plane[i] is what plane[i + stride] was before.
+     * Values that slid in from outside the grid are garbage,
+     * the caller has to clear the boundary face.
+     */
+    inline void slide(const std::ptrdiff_t stride)
+    {
+        make_room(stride);
+        offset += stride;
+    }
+
+    /* Moves the data so the window can slide by stride, or by any
+     * number of smaller steps in the same direction, without moving again;
+     * until then the buffer beyond the window is free to use.
+     */
+    inline void make_room(const std::ptrdiff_t stride)
+    {
+        if(stride > 0 && offset + stride > volume) {
+            std::memmove(storage.data(), data(), volume);
+            offset = 0;
+        }
+
+        if(stride < 0 && offset < static_cast<std::size_t>(-stride)) {
+            std::memmove(storage.data() + volume, data(), volume);
+            offset = volume;
+        }
+    }
+};
+
+
+/* Structure-of-arrays storage for the cells of a network.
+ * Every field of a cell lives in its own contiguous plane, indexed by
+ * the linear cell index (iz * y + iy) * x + ix, so a sweep
+ * that only touches one or two fields only streams those planes.
+ * iobuf[0..5] = east(+x), west(-x), north(+y), south(-y),
+ * top(+z), bottom(-z)
+ */
+template <typename Extent>
+struct cell_planes
+{
+    typename Extent::template buffer<cell_type> type;
+    typename Extent::template buffer<std::uint8_t> activation;
+    typename Extent::template buffer<std::uint8_t> chromo;
+    typename Extent::template buffer<std::uint8_t> gate;
+    std::array<lane_plane<Extent>, 6> iobuf;
+
+    explicit cell_planes(const Extent & extent)
+    {
+        extent.template allocate<cell_type, 1>(type);
+        extent.template allocate<std::uint8_t, 1>(activation);
+        extent.template allocate<std::uint8_t, 1>(chromo);
+        extent.template allocate<std::uint8_t, 1>(gate);
+
+        for(lane_plane<Extent> & lane : iobuf) {
+            lane.allocate(extent);
+        }
+    }
+};
+
+#endif
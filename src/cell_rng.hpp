@@ -0,0 +1,101 @@
+#ifndef CELL_RNG_H
+#define CELL_RNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+
+/* The mixing function of SplitMix64, a bijection on 64 bits
+ * whose outputs pass BigCrush for consecutive inputs.
+ */
+inline std::uint64_t splitmix64(std::uint64_t z)
+{
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+
+/* Counter-based random numbers for network construction.
+ * Every draw is a pure function of (seed, stream, cell coordinate),
+ * so cells can be initialized in any order, on any number of threads,
+ * and a seed always gives the same network. A cell keeps its numbers
+ * in grids of other sizes, and across parts of a split grid.
+ */
+class cell_rng
+{
+public:
+    // one per independent use, so draws for different purposes never collide
+    enum stream : std::uint64_t {
+        CHROMO,
+        NEURON_SEED,
+        ACTIVATION,
+        MUTATION,
+        MUTATION_BIT
+    };
+
+    /* The draws of one stream along a row of cells, with the work that is
+     * the same for the whole row done once: row(s, iz, iy)(ix) is (s, iz, iy, ix).
+     */
+    class row_draws
+    {
+    private:
+        std::uint64_t base;
+
+    public:
+        explicit row_draws(const std::uint64_t b) : base(b) { }
+
+        // the counter's x bits do not overlap the row's, so | is ^
+        inline std::uint64_t operator()(const int ix) const
+        {
+            return splitmix64(base ^ static_cast<std::uint64_t>(ix));
+        }
+    };
+
+private:
+    std::uint64_t key;
+
+public:
+    explicit cell_rng(const std::uint64_t seed) : key(splitmix64(seed)) { }
+
+    /* 64 random bits for the cell at (iz, iy, ix), coordinates below 2^21.
+     */
+    inline std::uint64_t operator()(const stream s, const int iz, const int iy, const int ix) const
+    {
+        const std::uint64_t counter =
+              (static_cast<std::uint64_t>(iz) << 42)
+            | (static_cast<std::uint64_t>(iy) << 21)
+            | static_cast<std::uint64_t>(ix);
+
+        return splitmix64(splitmix64(key + s) ^ counter);
+    }
+
+    inline row_draws row(const stream s, const int iz, const int iy) const
+    {
+        const std::uint64_t counter =
+              (static_cast<std::uint64_t>(iz) << 42)
+            | (static_cast<std::uint64_t>(iy) << 21);
+
+        return row_draws(splitmix64(key + s) ^ counter);
+    }
+
+    /* Uniform in [0, n), from the high 32 bits of r.
+     */
+    inline static std::uint32_t below(const std::uint64_t r, const std::uint32_t n)
+    {
+        return static_cast<std::uint32_t>(((r >> 32) * n) >> 32);
+    }
+};
+
+
+/* A fresh seed for a run nobody asked to reproduce.
+ */
+inline std::uint64_t random_seed()
+{
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef CELL_RULES_H
+#define CELL_RULES_H
+
+#include <cstdint>
+#include <string>
+
+
+/* The numbers in the CoDi rules, as a policy for basic_network and the
+ * signaling kernels: every rule set is a type of its own, so the numbers are
+ * constants the compiler folds into the inner loops.
+ *
+ *   Threshold       a neuron fires once its activation is above it
+ *   Gain            what a neuron adds to its activation every step on its own
+ *   DendriteClamp   the most a dendrite passes on towards its neuron in a step
+ *   ActivationRange neurons start signaling with an activation below it
+ *   PruneNum/Den    about this fraction of the neuron seeds on the lattice is
+ *                   dropped from a new chromosome
+ */
+template <int Threshold, int Gain, int DendriteClamp, int ActivationRange, int PruneNum, int PruneDen>
+struct rule_set
+{
+    // a lane carries at most a dendrite's clamped sum or a neuron's 1,
+    // and a neuron reads four of them
+    static constexpr int most_signal = DendriteClamp > 1 ? DendriteClamp : 1;
+    static constexpr int most_input = 4 * most_signal;
+
+    // an activation of 0 is a firing, so a neuron has to move every step
+    static_assert(Gain >= 1, "neurons need a gain");
+    static_assert(Threshold >= 0 && DendriteClamp >= 0, "no negative rules");
+    // not even from just above the threshold, where spike_io puts a neuron
+    static_assert(Threshold + 1 + Gain + most_input <= 255, "an activation must not wrap");
+    static_assert(ActivationRange > 0 && ActivationRange - 1 + Gain + most_input <= 255, "an initial activation must not wrap");
+    static_assert(PruneDen > 0 && PruneNum >= 0 && PruneNum <= PruneDen, "a fraction of the seeds");
+
+    static constexpr std::uint8_t threshold = Threshold;
+    static constexpr std::uint8_t gain = Gain;
+    static constexpr std::uint8_t dendrite_clamp = DendriteClamp;
+    static constexpr std::uint32_t activation_range = ActivationRange;
+    static constexpr int seed_prune_num = PruneNum;
+    static constexpr int seed_prune_den = PruneDen;
+};
+
+template <int T, int G, int C, int A, int N, int D> constexpr std::uint8_t rule_set<T, G, C, A, N, D>::threshold;
+template <int T, int G, int C, int A, int N, int D> constexpr std::uint8_t rule_set<T, G, C, A, N, D>::gain;
+template <int T, int G, int C, int A, int N, int D> constexpr std::uint8_t rule_set<T, G, C, A, N, D>::dendrite_clamp;
+template <int T, int G, int C, int A, int N, int D> constexpr std::uint32_t rule_set<T, G, C, A, N, D>::activation_range;
+template <int T, int G, int C, int A, int N, int D> constexpr int rule_set<T, G, C, A, N, D>::seed_prune_num;
+template <int T, int G, int C, int A, int N, int D> constexpr int rule_set<T, G, C, A, N, D>::seed_prune_den;
+template <int T, int G, int C, int A, int N, int D> constexpr int rule_set<T, G, C, A, N, D>::most_signal;
+template <int T, int G, int C, int A, int N, int D> constexpr int rule_set<T, G, C, A, N, D>::most_input;
+
+
+/* The rule sets compiled into the tools, by the name they are picked with.
+ */
+
+// the rules of the original model, the default everywhere
+struct codi_rules : rule_set<31, 1, 2, 33, 1, 2>
+{
+    static const char * name() { return "codi"; }
+};
+
+// neurons fire at half the activation, about twice as often
+struct eager_rules : rule_set<15, 1, 2, 17, 1, 2>
+{
+    static const char * name() { return "eager"; }
+};
+
+// neurons charge twice as fast on their own
+struct driven_rules : rule_set<31, 2, 2, 33, 1, 2>
+{
+    static const char * name() { return "driven"; }
+};
+
+// dendrites pass on a single signal at most
+struct narrow_rules : rule_set<31, 1, 1, 33, 1, 2>
+{
+    static const char * name() { return "narrow"; }
+};
+
+// three quarters of the neuron seeds are dropped instead of half
+struct sparse_rules : rule_set<31, 1, 2, 33, 3, 4>
+{
+    static const char * name() { return "sparse"; }
+};
+
+
+/* Picks one of a list of rule sets at run time: dispatch(name, f) calls
+ * f(Rules()) with the one called name, where f has an operator() template
+ * instantiated for each of them.
+ */
+template <typename... Rules>
+struct rule_list;
+
+template <>
+struct rule_list<>
+{
+    template <typename F>
+    static bool dispatch(const std::string &, F &)
+    {
+        return false;
+    }
+
+    static std::string names()
+    {
+        return "";
+    }
+};
+
+template <typename First, typename... Rest>
+struct rule_list<First, Rest...>
+{
+    /* False if none of them is called name.
+     */
+    template <typename F>
+    static bool dispatch(const std::string & name, F & f)
+    {
+        if(name == First::name()) {
+            f(First());
+            return true;
+        }
+
+        return rule_list<Rest...>::dispatch(name, f);
+    }
+
+    /* The names, separated by |.
+     */
+    static std::string names()
+    {
+        const std::string rest = rule_list<Rest...>::names();
+        return rest.empty() ? First::name() : First::name() + ("|" + rest);
+    }
+};
+
+typedef rule_list<codi_rules, eager_rules, driven_rules, narrow_rules, sparse_rules> compiled_rules;
+
+#endif
@@ -1,21 +1,26 @@
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <random>
 #include <array>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <thread>
 
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
 
 
+#include "async_stepper.hpp"
 #include "config.hpp"
 #include "network.hpp"
 #include "cell_color.hpp"
+#include "slice_renderer.hpp"
 
 
-network<GSize> nw;
-
 void render_ascii(const network<GSize> & nw)
 {
     int ix { 0 };
@@ -23,7 +28,7 @@ void render_ascii(const network<GSize> & nw)
     for(int iz=0; iz<GSize; ++iz) {
         for(int iy=0; iy<GSize; ++iy) {
             char c { ' ' };
-            switch(nw.grid[iz][iy][ix].type) {
+            switch(nw.type(iz, iy, ix)) {
                 case BLANK:    c = ' '; break;
                 case NEURON:   c = '@'; break;
                 case AXON:     c = '*'; break;
@@ -40,33 +45,23 @@ void render_ascii(const network<GSize> & nw)
 
 sf::Color cell_type_to_color(const cell_color c)
 {
-    const sf::Color neuron_color          (217, 184, 0,   255);
-    const sf::Color axon_color            (150, 50,  150, 150);
-    const sf::Color axon_signal_color     (255, 0,   200, 255); 
-    const sf::Color dendrite_color        (50,  150, 150, 150);
-    const sf::Color dendrite_signal_color (0,   255, 200, 255);
-    const sf::Color default_color         (60,  60,  60,  255);
-    
-    switch(c) {
-        case cell_color::DEFAULT:         return default_color;         break;
-        case cell_color::AXON_SIGNAL:     return axon_signal_color;     break;
-        case cell_color::DENDRITE_SIGNAL: return dendrite_signal_color; break;
-        case cell_color::NEURON:          return neuron_color;          break;
-        case cell_color::AXON:            return axon_color;            break;
-        case cell_color::DENDRITE:        return dendrite_color;        break;
-        default:                          return default_color;         break;
-    }
+    const std::array<std::uint8_t, 4> & rgba = color_rgba(c);
+    return sf::Color(rgba[0], rgba[1], rgba[2], rgba[3]);
 }
 
 
+/* Shows the slice of the renderer as one texture, scaled to the window,
+ * uploaded again only when a cell in it changed. The cells come from
+ * the latest copy the stepper made, the arrow keys ask it for another slice.
+ */
 bool render_2d(
     sf::RenderWindow & window,
-    const network<GSize> & nw, 
-    std::array<std::array<cell_color, GSize>, GSize> & render_space
+    async_stepper<network<GSize>>::observer & planes,
+    slice_renderer & slice,
+    sf::Texture & texture
 ) {
-    static int ix { 0 };
     sf::Event event;
-    
+
     while (window.pollEvent(event)) {
         if (event.type == sf::Event::Closed) {
             window.close();
@@ -74,6 +69,8 @@ bool render_2d(
         }
     }
 
+    int ix = slice.slice();
+
     if(sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Escape)) {
         return false;
     }
@@ -83,49 +80,23 @@ bool render_2d(
     }
     if(sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Right)) {
         ++ix;
-        if(ix == GSize-1) ix = 0;
+        if(ix == GSize) ix = 0;
     }
 
-    uint sg_w = std::floor(window_width / GSize);
-    uint sg_h = std::floor(window_height / GSize);
+    if(ix != slice.slice()) {
+        slice.set_slice(ix);
+        planes.set_planes(ix, ix + 1);
+    }
 
-    for(int iz=0; iz<GSize; ++iz) {
-        for(int iy=0; iy<GSize; ++iy) {
-            if(nw.grid[iz][iy][ix].type != BLANK) {
-                sf::RectangleShape square { sf::Vector2f(sg_w, sg_h) };
-                cell_color color { cell_color::DEFAULT };
-
-                if(nw.grid[iz][iy][ix].activation != 0) {
-                    if(nw.grid[iz][iy][ix].type != NEURON) {
-                        switch(nw.grid[iz][iy][ix].type) {
-                            case AXON:     color = cell_color::AXON_SIGNAL;     break;
-                            case DENDRITE: color = cell_color::DENDRITE_SIGNAL; break;
-                        }
-                    } else {
-                        color = cell_color::NEURON;
-                    }
-                } else {
-                    switch(nw.grid[iz][iy][ix].type) {
-                        case NEURON:   color = cell_color::NEURON;   break;
-                        case AXON:     color = cell_color::AXON;     break;
-                        case DENDRITE: color = cell_color::DENDRITE; break;
-                    }
-                }
-
-                square.setFillColor(cell_type_to_color(render_space[iz][iy]));
-                square.setPosition((sg_w*iz), (sg_h*iy));
-                window.draw(square);
-
-                if(render_space[iz][iy] != color) {
-                    render_space[iz][iy] = color;
-                    square.setFillColor(cell_type_to_color(color));
-                    square.setPosition((sg_w*iz), (sg_h*iy));
-                    window.draw(square);
-                }
-            }
-        }
+    const network_frame * frame = planes.latest();
+    if(frame && frame->has_plane(ix) && slice.update(*frame) != 0) {
+        texture.update(slice.pixels());
     }
 
+    sf::Sprite sprite(texture);
+    sprite.setScale(std::floor(window_width / GSize), std::floor(window_height / GSize));
+
+    window.draw(sprite);
     window.display();
     return true;
 }
@@ -134,19 +105,33 @@ bool render_2d(
 int main(int argc, char ** argv)
 {
     sf::RenderWindow window{{window_width, window_height}, "rnn"};
-    window.setFramerateLimit(10);
     window.clear(cell_type_to_color(cell_color::DEFAULT));
-    
-    std::array<std::array<cell_color, GSize>, GSize> render_space;
-
-    for(int i=0; ; ++i) {
-        std::cout << i << std::endl;
-        nw.step_ca();
-        //render_ascii(nw);
-        if(!render_2d(window, nw, render_space)) {
+
+    slice_renderer slice(GSize, GSize);
+    sf::Texture texture;
+    texture.create(slice.width(), slice.height());
+
+    std::unique_ptr<network<GSize>> nw { new network<GSize>() };
+    nw->set_threads(std::thread::hardware_concurrency());
+
+    // the network steps on a thread of its own as fast as it can,
+    // the window shows the latest slice at most 30 times a second
+    async_stepper<network<GSize>> stepper(*nw);
+    async_stepper<network<GSize>>::observer & planes = stepper.observe(slice.slice(), slice.slice() + 1);
+    const std::chrono::milliseconds frame_time { 33 };
+
+    stepper.start();
+
+    for(;;) {
+        std::this_thread::sleep_for(frame_time);
+
+        if(!render_2d(window, planes, slice, texture)) {
             break;
         }
+        window.setTitle("rnn, step " + std::to_string(stepper.steps_done()));
     }
 
+    stepper.stop();
+    //render_ascii(*nw);
     return 0;
 }
@@ -0,0 +1,237 @@
+#ifndef CYCLE_DETECTOR_H
+#define CYCLE_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "cell_rng.hpp"
+
+
+/* Finds where a signaling network starts to repeat itself.
+ *
+ * Without input from outside, signaling is deterministic and has finitely
+ * many states, so sooner or later a state comes back and from then on the
+ * network runs in a cycle. The state is the activation and the six lanes
+ * of every cell, hashed Zobrist style: the sum of a random 64 bit key for
+ * every 8 bytes of a plane and their value, 0 where they are 0.
+ * The keys are computed, not looked up, so hashing is one pass over the planes.
+ *
+ * The hash is taken every `every` steps and remembered with its step.
+ * Once one comes back, the network is in its cycle; it is hashed every step
+ * from there until that hash comes back again, which gives the exact period.
+ * onset() is the first hashed step in the cycle, which is where the cycle
+ * starts, or at most every - 1 steps after that. After step onset() the
+ * state is the one after onset() + period(), a fixed point having period 1.
+ * A 64 bit hash can collide, but is unlikely to within the few million
+ * steps a run remembers.
+ *
+ * Works on anything with signaling planes in `grid`, a network or a
+ * batch_network (where the batch cycles once all its members do).
+ */
+class cycle_detector
+{
+private:
+    unsigned long every;
+    std::uint64_t steps;
+    std::unordered_map<std::uint64_t, std::uint64_t> seen;
+    bool in_cycle;
+    std::uint64_t cycle_hash;
+    std::uint64_t cycle_step;
+    std::uint64_t first_step;
+    std::uint64_t cycle_steps;
+
+
+    inline static std::uint64_t plane_hash(const int plane, const std::uint8_t * p, const std::size_t n)
+    {
+        std::uint64_t h { 0 };
+        std::uint64_t key = splitmix64(plane) | 1;
+        std::size_t i { 0 };
+
+        // w * key is 0 only for w = 0, the rest of the mix keeps 0 at 0
+        for(; i + 8 <= n; i += 8, key += 0x9e3779b97f4a7c16ull) {
+            std::uint64_t w;
+            std::memcpy(&w, p + i, 8);
+
+            w *= key;
+            w ^= w >> 32;
+            w *= 0xd6e8feb86659fd93ull;
+            h += w ^ (w >> 29);
+        }
+
+        for(; i<n; ++i) {
+            h += splitmix64(key ^ i) * p[i];
+        }
+
+        return h;
+    }
+
+public:
+    explicit cycle_detector(const unsigned long every_steps = 1) :
+        every((every_steps > 0) ? every_steps : 1),
+        steps(0),
+        in_cycle(false),
+        cycle_hash(0),
+        cycle_step(0),
+        first_step(0),
+        cycle_steps(0)
+    {
+    }
+
+    /* The hash of the signaling state nw is in.
+     */
+    template <typename Network>
+    static std::uint64_t hash(const Network & nw)
+    {
+        const std::size_t n = nw.grid.activation.size();
+
+        std::uint64_t h = plane_hash(0, nw.grid.activation.data(), n);
+        for(int d=0; d<6; ++d) {
+            h += plane_hash(d + 1, nw.grid.iobuf[d].data(), n);
+        }
+
+        return h;
+    }
+
+    /* To be called with the state signaling starts from, then after every signaling step.
+     */
+    template <typename Network>
+    void observe(const Network & nw)
+    {
+        const std::uint64_t step = steps++;
+
+        if(found()) {
+            return;
+        }
+
+        if(in_cycle) {
+            if(hash(nw) == cycle_hash) {
+                cycle_steps = step - cycle_step;
+                seen.clear();
+            }
+            return;
+        }
+
+        if(step % every != 0) {
+            return;
+        }
+
+        const std::uint64_t h = hash(nw);
+        const auto first = seen.emplace(h, step);
+
+        if(!first.second) {
+            first_step = first.first->second;
+
+            if(every == 1) {
+                cycle_steps = step - first_step;
+                seen.clear();
+            } else {
+                in_cycle = true;
+                cycle_hash = h;
+                cycle_step = step;
+            }
+        }
+    }
+
+    /* Forgets everything, for a network that starts signaling anew.
+     */
+    void reset()
+    {
+        steps = 0;
+        seen.clear();
+        in_cycle = false;
+        first_step = 0;
+        cycle_steps = 0;
+    }
+
+    /* Signaling steps since the first observe().
+     */
+    inline std::uint64_t step_count() const
+    {
+        return (steps > 0) ? steps - 1 : 0;
+    }
+
+    inline bool found() const
+    {
+        return cycle_steps != 0;
+    }
+
+    inline std::uint64_t onset() const
+    {
+        return first_step;
+    }
+
+    inline std::uint64_t period() const
+    {
+        return cycle_steps;
+    }
+};
+
+
+enum class cycle_action {
+    DETECT,      // only find the cycle, step on as usual
+    STOP,        // stop stepping once the cycle is found
+    FAST_FORWARD // skip the whole cycles that are left, see signal_with_cycles
+};
+
+struct signal_outcome
+{
+    unsigned long steps;     // the step the network is in after the call
+    unsigned long simulated; // steps that were actually run
+};
+
+
+/* Up to `steps` signaling steps on a network that has stopped growing,
+ * watched by cycles, a fresh cycle_detector, calling step_done(nw) after each
+ * step that is run.
+ *
+ * FAST_FORWARD leaves the network in the state it would be in after
+ * all the steps, but only runs the steps until the cycle is found and then
+ * what is left over after dropping the whole cycles that remain.
+ * STOP returns as soon as the cycle is found, DETECT always runs all the steps.
+ */
+template <typename Network, typename Observer>
+signal_outcome signal_with_cycles(Network & nw, const unsigned long steps, cycle_detector & cycles,
+                                  const cycle_action action, Observer step_done)
+{
+    signal_outcome outcome { 0, 0 };
+
+    nw.prepare_signaling();
+    cycles.observe(nw);
+
+    while(outcome.steps < steps) {
+        if(cycles.found() && action == cycle_action::STOP) {
+            break;
+        }
+
+        if(cycles.found() && action == cycle_action::FAST_FORWARD) {
+            const unsigned long left = (steps - outcome.steps) % cycles.period();
+
+            for(unsigned long n=0; n<left; ++n) {
+                nw.step_ca();
+                step_done(nw);
+            }
+
+            outcome.simulated += left;
+            outcome.steps = steps;
+            break;
+        }
+
+        nw.step_ca();
+        step_done(nw);
+        cycles.observe(nw);
+        ++outcome.steps;
+        ++outcome.simulated;
+    }
+
+    return outcome;
+}
+
+template <typename Network>
+signal_outcome signal_with_cycles(Network & nw, const unsigned long steps, cycle_detector & cycles, const cycle_action action)
+{
+    return signal_with_cycles(nw, steps, cycles, action, [](const Network &) { });
+}
+
+#endif
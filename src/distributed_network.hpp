@@ -0,0 +1,450 @@
+#ifndef DISTRIBUTED_NETWORK_H
+#define DISTRIBUTED_NETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "cell_planes.hpp"
+#include "cell_rng.hpp"
+#include "cell_type.hpp"
+#include "grid_extent.hpp"
+#include "halo_transport.hpp"
+#include "network.hpp"
+#include "signal_kernel.hpp"
+#include "worker_pool.hpp"
+
+
+/* A network too big for one process, cut into slabs of z-planes,
+ * one per rank of a halo_transport, each process holding only its own.
+ *
+ * Every cell update only reads the cell itself, so a slab steps on its own
+ * up to the kick; the only thing crossing the cut is what the planes at
+ * either end send across it, the lanes into the neighboring slab. A step
+ * updates those two planes first and hands their outgoing lanes to the
+ * transport, then updates the inner planes while the faces are on
+ * their way, and puts the incoming faces in place after its own kick.
+ *
+ * Growth is a full scan (the frontier engine would have to follow its
+ * frontier across the cut), and whether any slab still grows is agreed on
+ * after every growth step. Every slab then holds what the same planes of
+ * basic_network(e, seed) hold after as many steps, bit for bit;
+ * gather() puts them together in one network, for when the whole grid is
+ * wanted in one place, live_cells() only adds up a count.
+ */
+class distributed_network
+{
+private:
+    dynamic_extent whole;
+    dynamic_extent extent; // of the slab
+    int z_offset;
+    std::uint64_t network_seed;
+    halo_transport & link;
+    bool changed;
+    bool has_setup_signaling;
+    std::unique_ptr<worker_pool> workers;
+    signal_kernel kernel;
+
+    typedef basic_network<dynamic_extent> rules;
+    typedef std::array<std::uint8_t *, 6> lane_pointers;
+
+    inline lane_pointers lanes()
+    {
+        return {{
+            grid.iobuf[0].data(), grid.iobuf[1].data(), grid.iobuf[2].data(),
+            grid.iobuf[3].data(), grid.iobuf[4].data(), grid.iobuf[5].data()
+        }};
+    }
+
+    inline std::size_t plane_size() const
+    {
+        return static_cast<std::size_t>(extent.x()) * extent.y();
+    }
+
+    inline bool has_below() const
+    {
+        return link.rank() > 0;
+    }
+
+    inline bool has_above() const
+    {
+        return link.rank() < link.ranks() - 1;
+    }
+
+
+    /* Runs kernel(begin, end) over the planes between the first and the last, in z-slabs.
+     */
+    template <typename Kernel>
+    void for_each_inner_slab(Kernel kernel)
+    {
+        const std::size_t inner = std::max(extent.z() - 2, 0);
+
+        if(!workers) {
+            kernel(plane_size(), (1 + inner) * plane_size());
+            return;
+        }
+
+        workers->run(inner, [&](unsigned, const std::size_t z_begin, const std::size_t z_end) {
+            kernel((1 + z_begin) * plane_size(), (1 + z_end) * plane_size());
+        });
+    }
+
+    /* Steps the end planes with update(begin, end), sends their lanes
+     * across the cuts, steps the rest, kicks and takes the faces in.
+     * Returns whether any update(...) returned true.
+     */
+    template <typename Update>
+    bool step_slab(Update update)
+    {
+        const std::size_t plane = plane_size();
+        const std::size_t top = (extent.z() - 1) * plane;
+        std::atomic<bool> any { false };
+
+        if(update(0, plane)) {
+            any = true;
+        }
+        if(top != 0 && update(top, top + plane)) {
+            any = true;
+        }
+
+        // what goes down is in the top lanes (4) of the bottom plane, what goes up in the bottom lanes (5) of the top plane
+        if(has_below()) {
+            link.send(link.rank() - 1, grid.iobuf[4].data(), plane);
+        }
+        if(has_above()) {
+            link.send(link.rank() + 1, grid.iobuf[5].data() + top, plane);
+        }
+
+        for_each_inner_slab([&](const std::size_t begin, const std::size_t end) {
+            if(update(begin, end)) {
+                any = true;
+            }
+        });
+
+        kicking();
+
+        if(has_above()) {
+            link.receive(link.rank() + 1, grid.iobuf[4].data() + top, plane);
+        }
+        if(has_below()) {
+            link.receive(link.rank() - 1, grid.iobuf[5].data(), plane);
+        }
+
+        return any;
+    }
+
+    /* network::kicking for the slab, the z faces at a cut are
+     * filled in by step_slab afterwards.
+     */
+    void kicking()
+    {
+        const std::ptrdiff_t nx = extent.x();
+        const int ny = extent.y();
+        const int nz = extent.z();
+        const std::ptrdiff_t nxy = plane_size();
+
+        grid.iobuf[0].slide(1);
+        grid.iobuf[1].slide(-1);
+        grid.iobuf[2].slide(nx);
+        grid.iobuf[3].slide(-nx);
+        grid.iobuf[4].slide(nxy);
+        grid.iobuf[5].slide(-nxy);
+
+        const lane_pointers io = lanes();
+
+        for(int iz=0; iz<nz; ++iz) {
+            for(int iy=0; iy<ny; ++iy) {
+                io[0][index(iz, iy, nx-1)] = 0;
+                io[1][index(iz, iy, 0)] = 0;
+            }
+
+            std::fill_n(io[2] + index(iz, ny-1, 0), nx, 0);
+            std::fill_n(io[3] + index(iz, 0, 0), nx, 0);
+        }
+
+        std::fill_n(io[4] + index(nz-1, 0, 0), nxy, 0);
+        std::fill_n(io[5], nxy, 0);
+    }
+
+
+    /* network::grow_cells.
+     */
+    bool grow_cells(const std::size_t begin, const std::size_t end)
+    {
+        const lane_pointers io = lanes();
+        bool grown { false };
+
+        for(std::size_t i=begin; i<end; ++i) {
+            cell_type type = grid.type[i];
+
+            if(type == BLANK) {
+                const std::array<std::uint8_t, 6> in {{ io[0][i], io[1][i], io[2][i], io[3][i], io[4][i], io[5][i] }};
+                type = rules::grow_blank(in, grid.chromo[i], grid.gate[i]);
+
+                if(type != BLANK) {
+                    grown = true;
+                    grid.type[i] = type;
+                }
+            }
+
+            for(int d=0; d<6; ++d) {
+                io[d][i] = rules::growth_output(type, grid.chromo[i], grid.gate[i], d);
+            }
+        }
+
+        return grown;
+    }
+
+    void growth_step()
+    {
+        const bool grown = step_slab([&](const std::size_t begin, const std::size_t end) {
+            return grow_cells(begin, end);
+        });
+
+        changed = link.any(grown);
+    }
+
+
+    void setup_signaling()
+    {
+        const cell_rng rng(network_seed);
+
+        has_setup_signaling = true;
+
+        grid.activation.fill(0);
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].fill(0);
+        }
+
+        for(int iz=0; iz<extent.z(); ++iz) {
+            for(int iy=0; iy<extent.y(); ++iy) {
+                for(int ix=0; ix<extent.x(); ++ix) {
+                    const std::size_t i = index(iz, iy, ix);
+
+                    if(grid.type[i] == NEURON) {
+                        grid.activation[i] = rules::initial_activation(rng, z_offset + iz, iy, ix);
+                    }
+                }
+            }
+        }
+    }
+
+    void signal_step()
+    {
+        const signal_planes planes { grid.type.data(), grid.gate.data(), grid.activation.data(), lanes() };
+
+        step_slab([&](const std::size_t begin, const std::size_t end) {
+            signal_cells(kernel, planes, begin, end);
+            return false;
+        });
+    }
+
+
+    static int slab_begin(const dynamic_extent & e, const int rank, const int ranks)
+    {
+        return static_cast<int>(static_cast<long>(e.z()) * rank / ranks);
+    }
+
+public:
+    cell_planes<dynamic_extent> grid;
+
+    /* This rank's slab of basic_network(e, seed). Each of the ranks
+     * of the transport gets about e.z() / ranks planes, at least one.
+     */
+    distributed_network(const dynamic_extent & e, const std::uint64_t seed, halo_transport & transport) :
+        whole(e),
+        extent(e.x(), e.y(), slab_begin(e, transport.rank() + 1, transport.ranks()) - slab_begin(e, transport.rank(), transport.ranks()),
+               e.huge_pages),
+        z_offset(slab_begin(e, transport.rank(), transport.ranks())),
+        network_seed(seed),
+        link(transport),
+        changed(true),
+        has_setup_signaling(false),
+        kernel(best_signal_kernel()),
+        grid((extent.z() > 0) ? extent : throw std::invalid_argument("distributed_network: more ranks than planes"))
+    {
+        const cell_rng rng(network_seed);
+
+        grid.type.fill(BLANK);
+        grid.activation.fill(0);
+        grid.gate.fill(0);
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].fill(0);
+        }
+
+        for(int iz=0; iz<extent.z(); ++iz) {
+            for(int iy=0; iy<extent.y(); ++iy) {
+                rules::initial_chromo_row(rng, z_offset + iz, iy, extent.x(), grid.chromo.data() + index(iz, iy, 0));
+            }
+        }
+    }
+
+
+    inline std::uint64_t seed() const
+    {
+        return network_seed;
+    }
+
+    /* The size of the whole network.
+     */
+    inline int size_x() const { return whole.x(); }
+    inline int size_y() const { return whole.y(); }
+    inline int size_z() const { return whole.z(); }
+
+    /* The planes [z_begin(), z_end()) of it this rank holds.
+     */
+    inline int z_begin() const { return z_offset; }
+    inline int z_end() const { return z_offset + extent.z(); }
+
+    /* Cells in this slab.
+     */
+    inline std::size_t volume() const
+    {
+        return extent.volume();
+    }
+
+    /* Of a cell of the slab, iz counting from z_begin().
+     */
+    inline std::size_t index(const int iz, const int iy, const int ix) const
+    {
+        return (static_cast<std::size_t>(iz) * extent.y() + iy) * extent.x() + ix;
+    }
+
+    inline cell_type type(const int iz, const int iy, const int ix) const
+    {
+        return grid.type[index(iz - z_offset, iy, ix)];
+    }
+
+    inline std::uint8_t activation(const int iz, const int iy, const int ix) const
+    {
+        return grid.activation[index(iz - z_offset, iy, ix)];
+    }
+
+    inline int rank() const
+    {
+        return link.rank();
+    }
+
+
+    void set_threads(const unsigned threads)
+    {
+        workers.reset(threads > 1 ? new worker_pool(threads) : nullptr);
+    }
+
+    inline unsigned threads() const
+    {
+        return workers ? workers->size() : 1;
+    }
+
+    inline void set_signal_kernel(const signal_kernel k)
+    {
+        kernel = k;
+    }
+
+
+    /* true until a growth step leaves every cell of every slab as it was.
+     */
+    inline bool growing() const
+    {
+        return changed;
+    }
+
+    inline bool signaling_ready() const
+    {
+        return has_setup_signaling;
+    }
+
+    void prepare_signaling()
+    {
+        if(!changed && !has_setup_signaling) {
+            setup_signaling();
+        }
+    }
+
+    /* Every rank has to step along, the steps wait for the neighbors' faces.
+     */
+    void step_ca()
+    {
+        if(changed) {
+            growth_step();
+        } else {
+            if(!has_setup_signaling) {
+                setup_signaling();
+            }
+
+            signal_step();
+        }
+    }
+
+
+    /* The live cells of the whole network, on every rank, which all have to call it.
+     */
+    std::uint64_t live_cells()
+    {
+        std::uint64_t live { 0 };
+
+        for(std::size_t i=0; i<volume(); ++i) {
+            live += (grid.type[i] != BLANK) ? 1 : 0;
+        }
+
+        return link.sum(live);
+    }
+
+    /* Collects every slab into one network on rank `root`, returned there
+     * and null on the other ranks, which all have to call it too.
+     */
+    std::unique_ptr<rules> gather(const int root = 0)
+    {
+        const std::size_t n = volume();
+        const std::array<std::uint8_t *, 4> planes {{
+            reinterpret_cast<std::uint8_t *>(grid.type.data()), grid.chromo.data(), grid.gate.data(), grid.activation.data()
+        }};
+        const lane_pointers io = lanes();
+
+        if(link.rank() != root) {
+            for(std::uint8_t * p : planes) {
+                link.send(root, p, n);
+            }
+            for(std::uint8_t * lane : io) {
+                link.send(root, lane, n);
+            }
+            return nullptr;
+        }
+
+        std::unique_ptr<rules> nw(new rules(whole, network_seed));
+        const std::array<std::uint8_t *, 4> to {{
+            reinterpret_cast<std::uint8_t *>(nw->grid.type.data()), nw->grid.chromo.data(), nw->grid.gate.data(),
+            nw->grid.activation.data()
+        }};
+
+        for(int r=0; r<link.ranks(); ++r) {
+            const std::size_t begin = nw->index(slab_begin(whole, r, link.ranks()), 0, 0);
+            const std::size_t end = nw->index(slab_begin(whole, r + 1, link.ranks()), 0, 0);
+
+            for(int p=0; p<4; ++p) {
+                if(r == root) {
+                    std::copy_n(planes[p], n, to[p] + begin);
+                } else {
+                    link.receive(r, to[p] + begin, end - begin);
+                }
+            }
+
+            for(int d=0; d<6; ++d) {
+                if(r == root) {
+                    std::copy_n(io[d], n, nw->grid.iobuf[d].data() + begin);
+                } else {
+                    link.receive(r, nw->grid.iobuf[d].data() + begin, end - begin);
+                }
+            }
+        }
+
+        nw->restore_state(network_seed, changed, has_setup_signaling);
+        return nw;
+    }
+};
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef EVOLUTION_H
+#define EVOLUTION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "batch_network.hpp"
+#include "cell_rng.hpp"
+#include "cycle_detector.hpp"
+#include "genome.hpp"
+#include "grid_extent.hpp"
+#include "network.hpp"
+#include "worker_pool.hpp"
+
+
+struct evolution_options
+{
+    std::size_t population;
+    std::size_t elite;                 // best genomes copied unchanged into the next generation
+    std::size_t tournament;            // genomes drawn per parent selection
+    double crossover_rate;             // probability a child has two parents
+    double mutation_rate;              // per cell, see genome::mutate
+    unsigned long max_growth_steps;    // networks still growing after that are scored as they are
+    unsigned long signal_steps;
+    bool skip_cycles;                  // fast-forward over signaling that repeats itself, see cycle_detector
+    unsigned long cycle_every;         // steps between its hashes
+    unsigned threads;
+    std::uint64_t seed;
+
+    evolution_options() :
+        population(64),
+        elite(2),
+        tournament(3),
+        crossover_rate(0.7),
+        mutation_rate(0.005),
+        max_growth_steps(1000),
+        signal_steps(100),
+        skip_cycles(false),
+        cycle_every(16),
+        threads(1),
+        seed(0)
+    { }
+};
+
+
+/* A genetic algorithm over genomes of one size.
+ *
+ * Every generation each genome grows into a network and signals for
+ * signal_steps steps, then the fitness callback scores it (higher is better).
+ * Networks are stepped 32 at a time in batch_networks, the batches spread
+ * over the worker threads, so the callback has to be safe to call from
+ * several threads at once. It gets a network that has stopped growing and
+ * signaled, or one that is still growing after max_growth_steps.
+ *
+ * All networks signal with the seed of the options, so a genome always gets
+ * the same fitness, and a run only depends on the options, not the threads.
+ * With skip_cycles, a batch whose signaling comes back to a state it was in
+ * skips the whole cycles left; the networks end in the same state either way.
+ * The networks run the rules of Rules (see cell_rules.hpp), evolution the
+ * default ones.
+ */
+template <typename Rules = codi_rules>
+class basic_evolution
+{
+public:
+    typedef basic_network<dynamic_extent, Rules> network_type;
+    typedef basic_genome<Rules> genome_type;
+    typedef std::function<double(const network_type &)> fitness_function;
+
+private:
+    static constexpr int batch_width = 32;
+
+    dynamic_extent extent;
+    evolution_options options;
+    fitness_function fitness;
+    std::unique_ptr<worker_pool> workers;
+
+    std::vector<genome_type> population;
+    std::vector<double> scores;
+    unsigned long generations;
+    bool evaluated;
+
+
+    inline static std::uint64_t derive_seed(const std::uint64_t seed, const std::uint64_t generation, const std::uint64_t n)
+    {
+        return splitmix64(splitmix64(seed ^ splitmix64(generation)) + n);
+    }
+
+    template <typename Network>
+    void signal(Network & nw) const
+    {
+        if(options.skip_cycles) {
+            cycle_detector cycles(options.cycle_every);
+            signal_with_cycles(nw, options.signal_steps, cycles, cycle_action::FAST_FORWARD);
+            return;
+        }
+
+        for(unsigned long step=0; step<options.signal_steps; ++step) {
+            nw.step_ca();
+        }
+    }
+
+    /* Grows, signals and scores population[begin, end) in one batch.
+     */
+    void evaluate_batch(const std::size_t begin, const std::size_t end, network_type & scratch)
+    {
+        batch_network<batch_width, Rules> batch(extent, std::vector<std::uint64_t>(end - begin, options.seed));
+
+        for(std::size_t n=begin; n<end; ++n) {
+            batch.set_chromo(n - begin, population[n].data());
+        }
+
+        for(unsigned long step=0; batch.growing() && step<options.max_growth_steps; ++step) {
+            batch.step_ca();
+        }
+
+        const bool grown = !batch.growing();
+        if(grown) {
+            signal(batch);
+        }
+
+        for(std::size_t n=begin; n<end; ++n) {
+            batch.store(n - begin, scratch);
+
+            // some other member did not converge, this one signals on its own
+            if(!grown && !scratch.growing()) {
+                signal(scratch);
+            }
+
+            scores[n] = fitness(scratch);
+        }
+    }
+
+    std::size_t select(std::uint64_t & state) const
+    {
+        std::size_t winner = splitmix64(state++) % population.size();
+
+        for(std::size_t t=1; t<options.tournament; ++t) {
+            const std::size_t other = splitmix64(state++) % population.size();
+            if(scores[other] > scores[winner]) {
+                winner = other;
+            }
+        }
+
+        return winner;
+    }
+
+public:
+    /* A random population, genome n from the seed derived from options.seed and n.
+     */
+    basic_evolution(const dynamic_extent & e, const fitness_function & f, const evolution_options & o = evolution_options()) :
+        extent(e),
+        options(o),
+        fitness(f),
+        generations(0),
+        evaluated(false)
+    {
+        if(options.population == 0 || options.elite > options.population) {
+            throw std::invalid_argument("evolution: need a population of at least the elite");
+        }
+
+        // written so that NaN fails too
+        if(!(options.mutation_rate >= 0 && options.mutation_rate <= 1) || !(options.crossover_rate >= 0 && options.crossover_rate <= 1)) {
+            throw std::invalid_argument("evolution: rates are probabilities");
+        }
+
+        if(options.threads > 1) {
+            workers.reset(new worker_pool(options.threads));
+        }
+
+        population.reserve(options.population);
+        for(std::size_t n=0; n<options.population; ++n) {
+            population.push_back(genome_type(extent, derive_seed(options.seed, 0, n)));
+        }
+
+        scores.assign(options.population, 0);
+    }
+
+
+    inline unsigned long generation() const
+    {
+        return generations;
+    }
+
+    inline const std::vector<genome_type> & genomes() const
+    {
+        return population;
+    }
+
+    /* Scores of genomes(), after evaluate().
+     */
+    inline const std::vector<double> & fitnesses() const
+    {
+        return scores;
+    }
+
+
+    /* Scores the current population, if it has not been yet.
+     */
+    void evaluate()
+    {
+        if(evaluated) {
+            return;
+        }
+
+        // at least one batch per thread, as long as there are genomes for it
+        const std::size_t threads = workers ? workers->size() : 1;
+        const std::size_t per_batch = std::min(static_cast<std::size_t>(batch_width), (population.size() + threads - 1) / threads);
+        const std::size_t batches = (population.size() + per_batch - 1) / per_batch;
+
+        const auto run = [&](unsigned, const std::size_t first, const std::size_t last) {
+            network_type scratch(extent, options.seed);
+
+            for(std::size_t b=first; b<last; ++b) {
+                evaluate_batch(b * per_batch, std::min(population.size(), (b + 1) * per_batch), scratch);
+            }
+        };
+
+        if(workers) {
+            workers->run(batches, run);
+        } else {
+            run(0, 0, batches);
+        }
+
+        evaluated = true;
+    }
+
+    /* Replaces the population with the elite and children of tournament
+     * winners, crossed over and mutated.
+     */
+    void next_generation()
+    {
+        evaluate();
+
+        std::vector<std::size_t> ranking(population.size());
+        for(std::size_t n=0; n<ranking.size(); ++n) {
+            ranking[n] = n;
+        }
+
+        std::stable_sort(ranking.begin(), ranking.end(), [&](const std::size_t a, const std::size_t b) {
+            return scores[a] > scores[b];
+        });
+
+        ++generations;
+
+        std::uint64_t state = derive_seed(options.seed, generations, 0);
+        const std::uint64_t crossover_threshold = static_cast<std::uint64_t>(options.crossover_rate * 9007199254740992.0);
+
+        std::vector<genome_type> next;
+        next.reserve(population.size());
+
+        for(std::size_t n=0; n<options.elite; ++n) {
+            next.push_back(population[ranking[n]]);
+        }
+
+        while(next.size() < population.size()) {
+            const genome_type & mother = population[select(state)];
+
+            if((splitmix64(state++) >> 11) < crossover_threshold) {
+                const genome_type & father = population[select(state)];
+                next.push_back(genome_type::crossover(mother, father, splitmix64(state++)));
+            } else {
+                next.push_back(mother);
+            }
+
+            next.back().mutate(splitmix64(state++), options.mutation_rate);
+        }
+
+        population.swap(next);
+        evaluated = false;
+    }
+
+    void run(const unsigned long count)
+    {
+        for(unsigned long g=0; g<count; ++g) {
+            next_generation();
+        }
+
+        evaluate();
+    }
+
+
+    /* The fittest genome of the current population, evaluating it first.
+     */
+    std::size_t best()
+    {
+        evaluate();
+        return std::max_element(scores.begin(), scores.end()) - scores.begin();
+    }
+};
+
+template <typename Rules> constexpr int basic_evolution<Rules>::batch_width;
+
+typedef basic_evolution<> evolution;
+
+#endif
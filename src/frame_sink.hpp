@@ -0,0 +1,121 @@
+#ifndef FRAME_SINK_H
+#define FRAME_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "slice_renderer.hpp"
+
+
+/* Where the frames of a slice_renderer go without a window, given as
+ *   ppm:PREFIX   a binary PPM file per frame, PREFIX000000.ppm, PREFIX000001.ppm, ...
+ *   raw:FILE     every frame as raw RGB24 one after the other
+ *   pipe:COMMAND the raw frames into the standard input of a shell command, e.g.
+ *                pipe:ffmpeg -f rawvideo -pix_fmt rgb24 -s ZxY -r 30 -i - run.mp4
+ * where Z by Y is the size of the slice, see slice_renderer.
+ */
+class frame_sink
+{
+private:
+    std::string kind;
+    std::string target;
+    std::FILE * out;
+    unsigned long frames;
+    std::vector<std::uint8_t> rgb;
+
+    void close()
+    {
+        if(!out) {
+            return;
+        }
+
+        if(kind == "pipe") {
+            ::pclose(out);
+        } else {
+            std::fclose(out);
+        }
+        out = nullptr;
+    }
+
+public:
+    explicit frame_sink(const std::string & spec) :
+        out(nullptr),
+        frames(0)
+    {
+        const std::size_t colon = spec.find(':');
+
+        kind = spec.substr(0, colon);
+        target = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+
+        if((kind != "ppm" && kind != "raw" && kind != "pipe") || target.empty()) {
+            throw std::invalid_argument("frame_sink: expected ppm:PREFIX, raw:FILE or pipe:COMMAND, not " + spec);
+        }
+
+        if(kind == "raw") {
+            out = std::fopen(target.c_str(), "wb");
+        } else if(kind == "pipe") {
+            out = ::popen(target.c_str(), "w");
+        }
+
+        if(kind != "ppm" && !out) {
+            throw std::runtime_error("frame_sink: could not open " + target);
+        }
+    }
+
+    ~frame_sink()
+    {
+        close();
+    }
+
+    frame_sink(const frame_sink &) = delete;
+    frame_sink & operator=(const frame_sink &) = delete;
+
+
+    inline unsigned long count() const
+    {
+        return frames;
+    }
+
+    void write(const slice_renderer & r)
+    {
+        const std::size_t pixels = static_cast<std::size_t>(r.width()) * r.height();
+        const std::uint8_t * rgba = r.pixels();
+
+        rgb.resize(3 * pixels);
+        for(std::size_t p=0; p<pixels; ++p) {
+            rgb[3 * p]     = rgba[4 * p];
+            rgb[3 * p + 1] = rgba[4 * p + 1];
+            rgb[3 * p + 2] = rgba[4 * p + 2];
+        }
+
+        if(kind == "ppm") {
+            char number[16];
+            std::snprintf(number, sizeof(number), "%06lu", frames);
+
+            const std::string name = target + number + ".ppm";
+            out = std::fopen(name.c_str(), "wb");
+            if(!out) {
+                throw std::runtime_error("frame_sink: could not write " + name);
+            }
+
+            std::fprintf(out, "P6\n%d %d\n255\n", r.width(), r.height());
+        }
+
+        const bool written = std::fwrite(rgb.data(), 1, rgb.size(), out) == rgb.size();
+
+        if(kind == "ppm") {
+            close();
+        }
+
+        if(!written) {
+            throw std::runtime_error("frame_sink: could not write frame to " + target);
+        }
+
+        ++frames;
+    }
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef GENOME_H
+#define GENOME_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include "cell_rng.hpp"
+#include "grid_extent.hpp"
+#include "network.hpp"
+
+
+/* The chromosome of a whole network: one byte per cell in index order,
+ * the growth instructions network grows from (see cell::chromo).
+ * Every operation keeps the lattice constraints of network::lattice_chromo,
+ * so any genome grows into a proper CoDi network; Rules are the rules it
+ * grows and signals with (see cell_rules.hpp), genome the default ones.
+ */
+template <typename Rules = codi_rules>
+class basic_genome
+{
+private:
+    int size_x;
+    int size_y;
+    int size_z;
+    std::vector<std::uint8_t> chromo;
+
+    inline std::size_t index(const int iz, const int iy, const int ix) const
+    {
+        return (static_cast<std::size_t>(iz) * size_y + iy) * size_x + ix;
+    }
+
+    typedef basic_network<dynamic_extent, Rules> rules;
+
+    // no chromosome yet, for read()
+    basic_genome(const int x, const int y, const int z) :
+        size_x(x),
+        size_y(y),
+        size_z(z)
+    { }
+
+public:
+    /* A random genome, the chromosome basic_network<dynamic_extent, Rules>(extent, seed) starts with.
+     */
+    basic_genome(const dynamic_extent & e, const std::uint64_t seed) :
+        size_x(e.x()),
+        size_y(e.y()),
+        size_z(e.z()),
+        chromo(e.volume())
+    {
+        const cell_rng rng(seed);
+
+        for(int iz=0; iz<size_z; ++iz) {
+            for(int iy=0; iy<size_y; ++iy) {
+                rules::initial_chromo_row(rng, iz, iy, size_x, chromo.data() + index(iz, iy, 0));
+            }
+        }
+    }
+
+    /* The chromosome nw was built from.
+     */
+    template <typename Network>
+    explicit basic_genome(const Network & nw) :
+        size_x(nw.size_x()),
+        size_y(nw.size_y()),
+        size_z(nw.size_z()),
+        chromo(nw.grid.chromo.data(), nw.grid.chromo.data() + nw.volume())
+    { }
+
+
+    inline dynamic_extent extent() const
+    {
+        return dynamic_extent(size_x, size_y, size_z);
+    }
+
+    inline std::size_t volume() const
+    {
+        return chromo.size();
+    }
+
+    inline const std::uint8_t * data() const
+    {
+        return chromo.data();
+    }
+
+    inline bool operator==(const basic_genome & other) const
+    {
+        return size_x == other.size_x && size_y == other.size_y && size_z == other.size_z && chromo == other.chromo;
+    }
+
+
+    /* Flips one random bit in each cell with probability rate,
+     * throws std::invalid_argument unless 0 <= rate <= 1.
+     */
+    void mutate(const std::uint64_t seed, const double rate)
+    {
+        if(!(rate >= 0 && rate <= 1)) {
+            throw std::invalid_argument("genome: the mutation rate is a probability");
+        }
+
+        const cell_rng rng(seed);
+        const std::uint32_t threshold = (rate >= 1) ? 0xffffffff : static_cast<std::uint32_t>(rate * 4294967296.0);
+
+        for(int iz=0; iz<size_z; ++iz) {
+            for(int iy=0; iy<size_y; ++iy) {
+                for(int ix=0; ix<size_x; ++ix) {
+                    if((rng(cell_rng::MUTATION, iz, iy, ix) >> 32) >= threshold) {
+                        continue;
+                    }
+
+                    std::uint8_t & c = chromo[index(iz, iy, ix)];
+                    c ^= 1 << cell_rng::below(rng(cell_rng::MUTATION_BIT, iz, iy, ix), 8);
+                    c = rules::lattice_chromo(c, iz, iy);
+                }
+            }
+        }
+    }
+
+    /* The first cells (in index order, i.e. whole z-slabs and rows) from a,
+     * the rest from b, with a random cut. Neighbors stay neighbors, so
+     * grown structures mostly survive.
+     */
+    static basic_genome crossover(const basic_genome & a, const basic_genome & b, const std::uint64_t seed)
+    {
+        if(a.size_x != b.size_x || a.size_y != b.size_y || a.size_z != b.size_z) {
+            throw std::invalid_argument("genome: crossover of genomes with different sizes");
+        }
+
+        basic_genome child(a);
+        const std::size_t cut = (splitmix64(seed) >> 11) % (a.volume() + 1);
+
+        std::copy(b.chromo.begin() + cut, b.chromo.end(), child.chromo.begin() + cut);
+        return child;
+    }
+
+
+    /* A network growing from this genome, signaling is seeded with seed.
+     */
+    std::unique_ptr<rules> build(const std::uint64_t seed, const bool huge_pages = false) const
+    {
+        std::unique_ptr<rules> nw { new rules(dynamic_extent(size_x, size_y, size_z, huge_pages), seed) };
+        nw->set_chromo(chromo.data());
+        return nw;
+    }
+
+
+    /* "CODIGENE", version, x, y, z as 32 bit values in host byte order, then the chromosome.
+     */
+    void write(std::ostream & out) const
+    {
+        const std::uint32_t header[4] = {
+            1, static_cast<std::uint32_t>(size_x), static_cast<std::uint32_t>(size_y), static_cast<std::uint32_t>(size_z)
+        };
+
+        out.write("CODIGENE", 8);
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(chromo.data()), chromo.size());
+    }
+
+    /* Throws std::runtime_error on anything that is not a genome.
+     */
+    static basic_genome read(std::istream & in)
+    {
+        char magic[8];
+        std::uint32_t header[4];
+
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char *>(header), sizeof(header));
+
+        if(!in || std::memcmp(magic, "CODIGENE", 8) != 0 || header[0] != 1) {
+            throw std::runtime_error("genome: not a genome");
+        }
+
+        if(header[1] == 0 || header[2] == 0 || header[3] == 0 || header[1] > 1u << 20 || header[2] > 1u << 20 || header[3] > 1u << 20) {
+            throw std::runtime_error("genome: broken size");
+        }
+
+        basic_genome g(header[1], header[2], header[3]);
+        const std::size_t volume = static_cast<std::size_t>(header[1]) * header[2] * header[3];
+
+        // the header alone does not get to allocate: check what a seekable stream
+        // holds, and only grow as far as the data goes on one that is not
+        const std::istream::pos_type here = in.tellg();
+        if(here != std::istream::pos_type(-1)) {
+            in.seekg(0, std::ios::end);
+            const std::istream::pos_type end = in.tellg();
+            in.seekg(here);
+
+            if(!in || end < here || static_cast<std::size_t>(end - here) < volume) {
+                throw std::runtime_error("genome: truncated");
+            }
+        }
+
+        constexpr std::size_t chunk = 1 << 24;
+        while(g.chromo.size() < volume) {
+            const std::size_t begin = g.chromo.size();
+
+            g.chromo.resize(begin + std::min(chunk, volume - begin));
+            in.read(reinterpret_cast<char *>(g.chromo.data() + begin), g.chromo.size() - begin);
+
+            if(!in) {
+                throw std::runtime_error("genome: truncated");
+            }
+        }
+
+        return g;
+    }
+};
+
+typedef basic_genome<> genome;
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef GRID_EXTENT_H
+#define GRID_EXTENT_H
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include "aligned_buffer.hpp"
+
+
+/* The size of a grid and how its planes are stored.
+ * Cells are laid out x fastest, then y, then z.
+ * buffer<T, Planes> is the storage for Planes whole planes of T,
+ * allocate() sizes it (a no-op for fixed sizes).
+ */
+
+
+/* Sizes known at compile time: the planes are std::arrays inside the
+ * network and every size computation folds into a constant.
+ */
+template <int X, int Y, int Z>
+struct fixed_extent
+{
+    static_assert(X > 0 && Y > 0 && Z > 0, "a grid needs at least one cell");
+
+    template <typename T, std::size_t Planes = 1>
+    using buffer = std::array<T, Planes * X * Y * Z>;
+
+    static constexpr int x() { return X; }
+    static constexpr int y() { return Y; }
+    static constexpr int z() { return Z; }
+
+    static constexpr std::size_t volume()
+    {
+        return static_cast<std::size_t>(X) * Y * Z;
+    }
+
+    template <typename T, std::size_t Planes>
+    void allocate(buffer<T, Planes> &) const { }
+};
+
+
+/* Sizes chosen at run time: the planes are aligned heap buffers,
+ * optionally backed by huge pages.
+ */
+struct dynamic_extent
+{
+    template <typename T, std::size_t Planes = 1>
+    using buffer = aligned_buffer<T>;
+
+    int size_x;
+    int size_y;
+    int size_z;
+    bool huge_pages;
+
+    dynamic_extent(const int x, const int y, const int z, const bool huge = false) :
+        size_x(x),
+        size_y(y),
+        size_z(z),
+        huge_pages(huge)
+    {
+        if(x <= 0 || y <= 0 || z <= 0) {
+            throw std::invalid_argument("dynamic_extent: a grid needs at least one cell");
+        }
+    }
+
+    inline int x() const { return size_x; }
+    inline int y() const { return size_y; }
+    inline int z() const { return size_z; }
+
+    inline std::size_t volume() const
+    {
+        return static_cast<std::size_t>(size_x) * size_y * size_z;
+    }
+
+    template <typename T, std::size_t Planes>
+    void allocate(aligned_buffer<T> & b) const
+    {
+        b.allocate(Planes * volume(), huge_pages);
+    }
+};
+
+#endif
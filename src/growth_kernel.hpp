@@ -0,0 +1,171 @@
+#ifndef GROWTH_KERNEL_H
+#define GROWTH_KERNEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "cell_type.hpp"
+#include "signal_kernel.hpp"
+
+
+/* The planes a growth kernel reads and writes, with the iobuf lanes
+ * already resolved to their current window.
+ */
+struct growth_planes
+{
+    cell_type * type;
+    const std::uint8_t * chromo;
+    std::uint8_t * gate;
+    std::array<std::uint8_t *, 6> io;
+};
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* The growth rules of network::grow_blank and network::growth_output
+ * without branches, on 16 or 32 cells at a time. uint8 sums wrap like
+ * the scalar fold_plus.
+ * grew has group bytes (a multiple of the vector width); the byte of a
+ * cell that grew, at its index modulo group, gets all bits set, so a batch
+ * of group interleaved networks can tell which of them grew.
+ * Returns the first index it did not process (end minus the remainder).
+ */
+template <typename V>
+__attribute__((always_inline)) inline std::size_t grow_cells_simd(const growth_planes & p, std::size_t i, const std::size_t end,
+                                                                  std::uint8_t * grew, const std::size_t group)
+{
+    constexpr std::size_t width = sizeof(V);
+
+    const V zero = { };
+
+    for(; i + width <= end; i += width) {
+        V type, chromo, gate;
+        simd_load(type, reinterpret_cast<const std::uint8_t *>(p.type) + i);
+        simd_load(chromo, p.chromo + i);
+        simd_load(gate, p.gate + i);
+
+        std::array<V, 6> in;
+        V sum = zero;
+        V axon_sum = zero;
+        V dendrite_sum = zero;
+        V axon_gate = gate;
+        V last_input = zero;
+
+#pragma GCC unroll 6
+        for(int d=0; d<6; ++d) {
+            simd_load(in[d], p.io[d] + i);
+            sum          += in[d];
+            axon_sum     += in[d] & static_cast<std::uint8_t>(AXON_SIGNAL);
+            dendrite_sum += in[d] & static_cast<std::uint8_t>(DENDRITE_SIGNAL);
+
+            const V from_axon = reinterpret_cast<V>(in[d] == static_cast<std::uint8_t>(AXON));
+            const V nonzero   = reinterpret_cast<V>(in[d] != 0);
+            axon_gate  = (from_axon & static_cast<std::uint8_t>(d)) | (~from_axon & axon_gate);
+            last_input = (nonzero & static_cast<std::uint8_t>(d)) | (~nonzero & last_input);
+        }
+
+        // (chromo & 63) % 6 by long division, the operand is below 96
+        V neuron_gate = chromo & 63;
+        for(const std::uint8_t m : { 48, 24, 12, 6 }) {
+            neuron_gate -= reinterpret_cast<V>(neuron_gate >= m) & m;
+        }
+
+        const V blank        = reinterpret_cast<V>(type == static_cast<std::uint8_t>(BLANK));
+        const V seed         = reinterpret_cast<V>((chromo >> 6) == static_cast<std::uint8_t>(NEURONSEED));
+        const V to_neuron    = blank & seed;
+        const V signaled     = blank & ~seed & reinterpret_cast<V>(sum != 0);
+        const V to_axon      = signaled & reinterpret_cast<V>(axon_sum == static_cast<std::uint8_t>(AXON_SIGNAL));
+        const V to_dendrite  = signaled & reinterpret_cast<V>(axon_sum == 0) & reinterpret_cast<V>(dendrite_sum == static_cast<std::uint8_t>(DENDRITE_SIGNAL));
+        const V grown        = to_neuron | to_axon | to_dendrite;
+
+        const V new_type = type
+            | (to_neuron   & static_cast<std::uint8_t>(NEURON))
+            | (to_axon     & static_cast<std::uint8_t>(AXON))
+            | (to_dendrite & static_cast<std::uint8_t>(DENDRITE));
+
+        const V new_gate =
+              (to_neuron   & neuron_gate)
+            | (to_axon     & axon_gate)
+            | (to_dendrite & (last_input ^ 1))
+            | (~grown      & gate);
+
+        simd_store(reinterpret_cast<std::uint8_t *>(p.type) + i, new_type);
+        simd_store(p.gate + i, new_gate);
+
+        V grew_before;
+        simd_load(grew_before, grew + i % group);
+        simd_store(grew + i % group, grew_before | grown);
+
+        // live cells send their growth signals, blank ones 0
+        const V is_neuron   = reinterpret_cast<V>(new_type == static_cast<std::uint8_t>(NEURON));
+        const V is_axon     = reinterpret_cast<V>(new_type == static_cast<std::uint8_t>(AXON));
+        const V is_dendrite = reinterpret_cast<V>(new_type == static_cast<std::uint8_t>(DENDRITE));
+
+#pragma GCC unroll 6
+        for(int d=0; d<6; ++d) {
+            const V along_axon = reinterpret_cast<V>(new_gate == static_cast<std::uint8_t>(d))
+                               | reinterpret_cast<V>(new_gate == static_cast<std::uint8_t>(d ^ 1));
+            const V chromo_bit = reinterpret_cast<V>(((chromo >> d) & 1) != 0);
+
+            const V out =
+                  (is_neuron   & ((along_axon & static_cast<std::uint8_t>(AXON_SIGNAL)) | (~along_axon & static_cast<std::uint8_t>(DENDRITE_SIGNAL))))
+                | (is_axon     & chromo_bit & static_cast<std::uint8_t>(AXON_SIGNAL))
+                | (is_dendrite & chromo_bit & static_cast<std::uint8_t>(DENDRITE_SIGNAL));
+
+            simd_store(p.io[d] + i, out);
+        }
+    }
+
+    return i;
+}
+
+
+inline std::size_t grow_cells_sse2(const growth_planes & p, const std::size_t begin, const std::size_t end,
+                                   std::uint8_t * grew, const std::size_t group)
+{
+    return grow_cells_simd<u8x16>(p, begin, end, grew, group);
+}
+
+__attribute__((target("avx2")))
+inline std::size_t grow_cells_avx2(const growth_planes & p, const std::size_t begin, const std::size_t end,
+                                   std::uint8_t * grew, const std::size_t group)
+{
+    return grow_cells_simd<u8x32>(p, begin, end, grew, group);
+}
+
+#endif
+
+
+/* Runs the vector growth kernel picked by k over [begin, end) as far as it
+ * can; group has to be a multiple of its width, otherwise it does nothing.
+ * Returns the first index left for the scalar rules.
+ */
+inline std::size_t grow_cells_vector(const signal_kernel k, const growth_planes & p, const std::size_t begin, const std::size_t end,
+                                     std::uint8_t * grew, const std::size_t group)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch(k) {
+        case signal_kernel::AVX2:
+            if(group % 32 == 0 && begin % 32 == 0) {
+                return grow_cells_avx2(p, begin, end, grew, group);
+            }
+            // fall through
+        case signal_kernel::SSE2:
+            if(group % 16 == 0 && begin % 16 == 0) {
+                return grow_cells_sse2(p, begin, end, grew, group);
+            }
+            break;
+        case signal_kernel::SCALAR: break;
+    }
+#else
+    (void)k;
+    (void)p;
+    (void)end;
+    (void)grew;
+    (void)group;
+#endif
+
+    return begin;
+}
+
+#endif
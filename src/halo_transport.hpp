@@ -0,0 +1,668 @@
+#ifndef HALO_TRANSPORT_H
+#define HALO_TRANSPORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef CODI_MPI
+#include <mpi.h>
+#endif
+
+
+/* How the processes of a distributed_network reach each other:
+ * ranks 0 to ranks()-1, each sending byte messages to any other.
+ *
+ * send() must not wait for the other side to receive, so two ranks can
+ * send each other their faces and then receive, and messages between two
+ * ranks arrive in the order they were sent. A rank that fails calls abort(),
+ * so the others throw instead of waiting for it forever.
+ */
+class halo_transport
+{
+public:
+    virtual ~halo_transport() { }
+
+    virtual int rank() const = 0;
+    virtual int ranks() const = 0;
+
+    /* Hands n bytes for rank `to` over and returns, data can be reused at once.
+     */
+    virtual void send(const int to, const void * data, const std::size_t n) = 0;
+
+    /* Waits for the next n bytes from rank `from`.
+     */
+    virtual void receive(const int from, void * data, const std::size_t n) = 0;
+
+    /* true on every rank once any rank passed true.
+     */
+    virtual bool any(const bool b)
+    {
+        std::uint8_t result = b ? 1 : 0;
+
+        if(rank() != 0) {
+            send(0, &result, 1);
+            receive(0, &result, 1);
+            return result != 0;
+        }
+
+        for(int r=1; r<ranks(); ++r) {
+            std::uint8_t other { 0 };
+            receive(r, &other, 1);
+            result |= other;
+        }
+
+        for(int r=1; r<ranks(); ++r) {
+            send(r, &result, 1);
+        }
+
+        return result != 0;
+    }
+
+    /* The sum of v over all ranks, on every rank.
+     */
+    virtual std::uint64_t sum(const std::uint64_t v)
+    {
+        std::uint64_t result = v;
+
+        if(rank() != 0) {
+            send(0, &result, sizeof(result));
+            receive(0, &result, sizeof(result));
+            return result;
+        }
+
+        for(int r=1; r<ranks(); ++r) {
+            std::uint64_t other { 0 };
+            receive(r, &other, sizeof(other));
+            result += other;
+        }
+
+        for(int r=1; r<ranks(); ++r) {
+            send(r, &result, sizeof(result));
+        }
+
+        return result;
+    }
+
+    /* This rank gave up: every rank waiting on it, now or later, throws.
+     */
+    virtual void abort() { }
+};
+
+
+/* Unix domain sockets between processes of one machine, for testing.
+ * Rank r listens on path.r and connects to every lower rank, so all ranks
+ * can be started at once in any order. A thread of its own writes what
+ * send() queued, so sending never waits for the other side.
+ */
+class socket_transport : public halo_transport
+{
+private:
+    int my_rank;
+    int rank_count;
+    std::string listen_path;
+    std::vector<int> sockets;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::deque<std::pair<int, std::vector<std::uint8_t>>> queue;
+    bool stopping;
+    bool broken; // a write failed, what is left is dropped
+
+
+    static sockaddr_un address(const std::string & path)
+    {
+        sockaddr_un a;
+        std::memset(&a, 0, sizeof(a));
+        a.sun_family = AF_UNIX;
+
+        if(path.size() >= sizeof(a.sun_path)) {
+            throw std::invalid_argument("socket_transport: socket path too long: " + path);
+        }
+
+        std::strcpy(a.sun_path, path.c_str());
+        return a;
+    }
+
+    static void write_all(const int fd, const std::uint8_t * data, std::size_t n)
+    {
+        while(n > 0) {
+            const ssize_t written = ::send(fd, data, n, MSG_NOSIGNAL);
+
+            if(written < 0 && errno == EINTR) {
+                continue;
+            }
+            if(written <= 0) {
+                throw std::runtime_error("socket_transport: send failed");
+            }
+
+            data += written;
+            n -= written;
+        }
+    }
+
+    static void read_all(const int fd, std::uint8_t * data, std::size_t n)
+    {
+        while(n > 0) {
+            const ssize_t got = ::recv(fd, data, n, 0);
+
+            if(got < 0 && errno == EINTR) {
+                continue;
+            }
+            if(got <= 0) {
+                throw std::runtime_error("socket_transport: the other rank hung up");
+            }
+
+            data += got;
+            n -= got;
+        }
+    }
+
+    void write_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for(;;) {
+            wake.wait(lock, [&] { return stopping || !queue.empty(); });
+
+            if(queue.empty()) {
+                return;
+            }
+
+            const std::pair<int, std::vector<std::uint8_t>> message = std::move(queue.front());
+            lock.unlock();
+            try {
+                write_all(message.first, message.second.data(), message.second.size());
+            } catch(const std::runtime_error &) {
+                // the other rank is gone, its receive() fails on our end too
+                lock.lock();
+                broken = true;
+                queue.clear();
+                drained.notify_all();
+                return;
+            }
+            lock.lock();
+
+            queue.pop_front();
+            if(queue.empty()) {
+                drained.notify_all();
+            }
+        }
+    }
+
+public:
+    socket_transport(const std::string & path, const int rank, const int ranks) :
+        my_rank(rank),
+        rank_count(ranks),
+        listen_path(path + "." + std::to_string(rank)),
+        sockets(ranks, -1),
+        stopping(false),
+        broken(false)
+    {
+        if(rank < 0 || rank >= ranks) {
+            throw std::invalid_argument("socket_transport: rank out of range");
+        }
+
+        int listener { -1 };
+
+        if(rank < ranks - 1) {
+            const sockaddr_un a = address(listen_path);
+            ::unlink(listen_path.c_str());
+
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if(listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr *>(&a), sizeof(a)) != 0
+               || ::listen(listener, ranks) != 0) {
+                throw std::runtime_error("socket_transport: could not listen on " + listen_path);
+            }
+        }
+
+        // the lower ranks may not listen yet, keep trying for a while
+        for(int r=0; r<rank; ++r) {
+            const sockaddr_un a = address(path + "." + std::to_string(r));
+            const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+            for(;;) {
+                const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if(fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr *>(&a), sizeof(a)) == 0) {
+                    sockets[r] = fd;
+                    break;
+                }
+
+                ::close(fd);
+                if(std::chrono::steady_clock::now() > give_up) {
+                    throw std::runtime_error("socket_transport: could not reach rank " + std::to_string(r));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            const std::int32_t me = rank;
+            write_all(sockets[r], reinterpret_cast<const std::uint8_t *>(&me), sizeof(me));
+        }
+
+        for(int n=rank+1; n<ranks; ++n) {
+            const int fd = ::accept(listener, nullptr, nullptr);
+            std::int32_t other { -1 };
+
+            if(fd < 0) {
+                throw std::runtime_error("socket_transport: accept failed");
+            }
+
+            read_all(fd, reinterpret_cast<std::uint8_t *>(&other), sizeof(other));
+            if(other <= rank || other >= ranks || sockets[other] != -1) {
+                throw std::runtime_error("socket_transport: unexpected peer");
+            }
+            sockets[other] = fd;
+        }
+
+        if(listener >= 0) {
+            ::close(listener);
+            ::unlink(listen_path.c_str());
+        }
+
+        writer = std::thread(&socket_transport::write_loop, this);
+    }
+
+    ~socket_transport()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            drained.wait(lock, [&] { return queue.empty(); });
+            stopping = true;
+        }
+
+        wake.notify_one();
+        writer.join();
+
+        for(const int fd : sockets) {
+            if(fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    socket_transport(const socket_transport &) = delete;
+    socket_transport & operator=(const socket_transport &) = delete;
+
+
+    int rank() const override
+    {
+        return my_rank;
+    }
+
+    int ranks() const override
+    {
+        return rank_count;
+    }
+
+    void send(const int to, const void * data, const std::size_t n) override
+    {
+        const std::uint8_t * bytes = static_cast<const std::uint8_t *>(data);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(broken) {
+                throw std::runtime_error("socket_transport: send failed");
+            }
+            queue.emplace_back(sockets[to], std::vector<std::uint8_t>(bytes, bytes + n));
+        }
+
+        wake.notify_one();
+    }
+
+    void receive(const int from, void * data, const std::size_t n) override
+    {
+        read_all(sockets[from], static_cast<std::uint8_t *>(data), n);
+    }
+
+    // the others read end of file from us
+    void abort() override
+    {
+        for(const int fd : sockets) {
+            if(fd >= 0) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+    }
+};
+
+
+/* POSIX shared memory between processes of one machine: one byte ring of
+ * `capacity` bytes per ordered pair of ranks, after a flag abort() raises,
+ * in a segment called `name` that every rank maps. A send only waits while its ring is full, so the
+ * capacity has to hold what a rank sends before it receives again.
+ * name has to be new to the machine, e.g. carry the pid of the launcher:
+ * rank 0 makes the segment and fails on one left over from another run.
+ * It is unlinked when the transport goes away.
+ */
+class shm_transport : public halo_transport
+{
+private:
+    struct alignas(64) ring_header
+    {
+        std::atomic<std::uint64_t> written;
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+        std::atomic<std::uint64_t> read;
+    };
+
+    struct alignas(64) control_block
+    {
+        std::atomic<std::uint32_t> aborted;
+    };
+
+    int my_rank;
+    int rank_count;
+    std::string segment_name;
+    std::size_t ring_capacity;
+    std::size_t ring_bytes;
+    std::size_t segment_bytes;
+    std::uint8_t * segment;
+
+
+    inline ring_header & header(const int from, const int to)
+    {
+        return *reinterpret_cast<ring_header *>(segment + sizeof(control_block) + (static_cast<std::size_t>(from) * rank_count + to) * ring_bytes);
+    }
+
+    inline std::uint8_t * ring_data(const int from, const int to)
+    {
+        return segment + sizeof(control_block) + (static_cast<std::size_t>(from) * rank_count + to) * ring_bytes + sizeof(ring_header);
+    }
+
+    inline control_block & control()
+    {
+        return *reinterpret_cast<control_block *>(segment);
+    }
+
+    // called while waiting
+    inline void check_aborted()
+    {
+        if(control().aborted.load(std::memory_order_relaxed) != 0) {
+            throw std::runtime_error("shm_transport: another rank failed");
+        }
+    }
+
+    // the other ranks may have mapped a segment rank 0 cannot use, let them fail too
+    static void abort_left_over(const std::string & name)
+    {
+        const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        struct stat s;
+
+        if(fd >= 0 && ::fstat(fd, &s) == 0 && static_cast<std::size_t>(s.st_size) >= sizeof(control_block)) {
+            void * mapped = ::mmap(nullptr, sizeof(control_block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(mapped != MAP_FAILED) {
+                static_cast<control_block *>(mapped)->aborted.store(1, std::memory_order_relaxed);
+                ::munmap(mapped, sizeof(control_block));
+            }
+        }
+        if(fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+public:
+    shm_transport(const std::string & name, const int rank, const int ranks, const std::size_t capacity) :
+        my_rank(rank),
+        rank_count(ranks),
+        segment_name(name),
+        ring_capacity(capacity),
+        ring_bytes(sizeof(ring_header) + (capacity + 63) / 64 * 64),
+        segment_bytes(sizeof(control_block) + ring_bytes * ranks * ranks),
+        segment(nullptr)
+    {
+        static_assert(sizeof(ring_header) == 128 && sizeof(control_block) == 64, "written and read on cache lines of their own");
+
+        if(rank < 0 || rank >= ranks || capacity == 0) {
+            throw std::invalid_argument("shm_transport: rank out of range");
+        }
+
+        // rank 0 makes the segment, new and so all zeros, every ring empty;
+        // the others may not find it yet, keep trying for a while
+        int fd { -1 };
+        if(rank == 0) {
+            fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if(fd < 0 && errno == EEXIST) {
+                abort_left_over(name);
+                throw std::runtime_error("shm_transport: " + name + " is left over from another run");
+            }
+            if(fd >= 0 && ::ftruncate(fd, segment_bytes) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        } else {
+            const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+            // rank 0 sizes it after making it
+            struct stat s;
+            while((fd = ::shm_open(name.c_str(), O_RDWR, 0)) < 0
+                  || ::fstat(fd, &s) != 0 || static_cast<std::size_t>(s.st_size) != segment_bytes) {
+                if(fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+                if(std::chrono::steady_clock::now() > give_up) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        if(fd < 0) {
+            throw std::runtime_error("shm_transport: could not open " + name);
+        }
+
+        void * mapped = ::mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if(mapped == MAP_FAILED) {
+            throw std::runtime_error("shm_transport: could not map " + name);
+        }
+
+        segment = static_cast<std::uint8_t *>(mapped);
+    }
+
+    ~shm_transport()
+    {
+        ::munmap(segment, segment_bytes);
+        ::shm_unlink(segment_name.c_str());
+    }
+
+    shm_transport(const shm_transport &) = delete;
+    shm_transport & operator=(const shm_transport &) = delete;
+
+
+    int rank() const override
+    {
+        return my_rank;
+    }
+
+    int ranks() const override
+    {
+        return rank_count;
+    }
+
+    void send(const int to, const void * data, std::size_t n) override
+    {
+        ring_header & h = header(my_rank, to);
+        std::uint8_t * ring = ring_data(my_rank, to);
+        const std::uint8_t * bytes = static_cast<const std::uint8_t *>(data);
+        std::uint64_t written = h.written.load(std::memory_order_relaxed);
+
+        while(n > 0) {
+            std::size_t space;
+            while((space = ring_capacity - (written - h.read.load(std::memory_order_acquire))) == 0) {
+                check_aborted();
+                std::this_thread::yield();
+            }
+
+            const std::size_t at = written % ring_capacity;
+            const std::size_t chunk = std::min(std::min(n, space), ring_capacity - at);
+
+            std::memcpy(ring + at, bytes, chunk);
+            written += chunk;
+            h.written.store(written, std::memory_order_release);
+
+            bytes += chunk;
+            n -= chunk;
+        }
+    }
+
+    void receive(const int from, void * data, std::size_t n) override
+    {
+        ring_header & h = header(from, my_rank);
+        const std::uint8_t * ring = ring_data(from, my_rank);
+        std::uint8_t * bytes = static_cast<std::uint8_t *>(data);
+        std::uint64_t read = h.read.load(std::memory_order_relaxed);
+
+        while(n > 0) {
+            std::size_t ready;
+            while((ready = h.written.load(std::memory_order_acquire) - read) == 0) {
+                check_aborted();
+                std::this_thread::yield();
+            }
+
+            const std::size_t at = read % ring_capacity;
+            const std::size_t chunk = std::min(std::min(n, ready), ring_capacity - at);
+
+            std::memcpy(bytes, ring + at, chunk);
+            read += chunk;
+            h.read.store(read, std::memory_order_release);
+
+            bytes += chunk;
+            n -= chunk;
+        }
+    }
+
+    void abort() override
+    {
+        control().aborted.store(1, std::memory_order_relaxed);
+    }
+};
+
+
+#ifdef CODI_MPI
+
+/* MPI point to point, built with make MPI=1. MPI_Init is up to the caller.
+ * Sends are nonblocking on a copy that is kept until MPI is done with it.
+ * MPI counts are ints, so messages go in pieces of at most INT_MAX bytes.
+ */
+class mpi_transport : public halo_transport
+{
+private:
+    // only ever read as a value, so it needs no definition outside the class
+    static constexpr std::size_t most_bytes = INT_MAX;
+
+    MPI_Comm comm;
+    int my_rank;
+    int rank_count;
+    std::deque<std::pair<std::vector<std::uint8_t>, MPI_Request>> pending;
+
+    void finish_sends(const bool wait)
+    {
+        while(!pending.empty()) {
+            int done { 0 };
+
+            if(wait) {
+                MPI_Wait(&pending.front().second, MPI_STATUS_IGNORE);
+                done = 1;
+            } else {
+                MPI_Test(&pending.front().second, &done, MPI_STATUS_IGNORE);
+            }
+
+            if(!done) {
+                return;
+            }
+            pending.pop_front();
+        }
+    }
+
+public:
+    explicit mpi_transport(MPI_Comm c = MPI_COMM_WORLD) :
+        comm(c)
+    {
+        MPI_Comm_rank(comm, &my_rank);
+        MPI_Comm_size(comm, &rank_count);
+    }
+
+    ~mpi_transport()
+    {
+        finish_sends(true);
+    }
+
+    int rank() const override
+    {
+        return my_rank;
+    }
+
+    int ranks() const override
+    {
+        return rank_count;
+    }
+
+    void send(const int to, const void * data, const std::size_t n) override
+    {
+        const std::uint8_t * bytes = static_cast<const std::uint8_t *>(data);
+
+        finish_sends(false);
+        for(std::size_t at=0; at<n; at+=most_bytes) {
+            const std::size_t chunk = (n - at < most_bytes) ? n - at : most_bytes;
+            pending.emplace_back(std::vector<std::uint8_t>(bytes + at, bytes + at + chunk), MPI_Request());
+            MPI_Isend(pending.back().first.data(), static_cast<int>(chunk), MPI_BYTE, to, 0, comm, &pending.back().second);
+        }
+    }
+
+    // messages between two ranks arrive in order, the chunks come back as sent
+    void receive(const int from, void * data, const std::size_t n) override
+    {
+        std::uint8_t * bytes = static_cast<std::uint8_t *>(data);
+
+        for(std::size_t at=0; at<n; at+=most_bytes) {
+            const std::size_t chunk = (n - at < most_bytes) ? n - at : most_bytes;
+            MPI_Recv(bytes + at, static_cast<int>(chunk), MPI_BYTE, from, 0, comm, MPI_STATUS_IGNORE);
+        }
+    }
+
+    bool any(const bool b) override
+    {
+        int in = b ? 1 : 0, out { 0 };
+        MPI_Allreduce(&in, &out, 1, MPI_INT, MPI_LOR, comm);
+        return out != 0;
+    }
+
+    std::uint64_t sum(const std::uint64_t v) override
+    {
+        std::uint64_t out { 0 };
+        MPI_Allreduce(&v, &out, 1, MPI_UINT64_T, MPI_SUM, comm);
+        return out;
+    }
+
+    void abort() override
+    {
+        MPI_Abort(comm, 1);
+    }
+};
+
+#endif
+
+#endif
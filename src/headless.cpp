@@ -0,0 +1,802 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cycle_detector.hpp"
+#include "distributed_network.hpp"
+#include "frame_sink.hpp"
+#include "network.hpp"
+#include "packed_network.hpp"
+#include "slice_renderer.hpp"
+#include "snapshot.hpp"
+#include "spike_raster.hpp"
+
+
+/* Runs networks without a window, for batches and profiling.
+ * Nothing is printed while stepping, the report comes at the end:
+ * steps, seconds, steps/sec and cell-updates/sec (cells * steps / sec)
+ * for the growth and the signaling phase.
+ */
+
+
+#ifdef CODI_MPI
+constexpr bool mpi_built = true;
+#else
+constexpr bool mpi_built = false;
+#endif
+
+
+struct run_options
+{
+    int size_x { 128 };
+    int size_y { 128 };
+    int size_z { 128 };
+    bool seeded { false };
+    std::uint64_t seed { 0 };
+    unsigned long growth_steps { 0 }; // 0 is until growth converges
+    unsigned long signal_steps { 1000 };
+    unsigned threads { std::thread::hardware_concurrency() };
+    bool huge_pages { false };
+    bool packed { false };
+    int tile_steps { 1 };
+    int ranks { 1 };
+    std::string transport { "socket" };
+    growth_engine grower { growth_engine::FRONTIER };
+    std::string format { "text" };
+    std::string output;
+    std::string load;
+    std::string save;
+    std::string stats;
+    std::string stats_format { "json" };
+    unsigned long stats_every { 100 };
+    std::string render;
+    unsigned long render_every { 1 };
+    int render_slice { 0 };
+    std::string record;
+    raster_kind record_kind { RASTER_FIRINGS };
+    unsigned long record_every { 1 };
+    std::string cycles;
+    unsigned long cycle_every { 16 };
+    std::string rules { codi_rules::name() };
+};
+
+
+struct phase_report
+{
+    unsigned long steps { 0 };
+    double seconds { 0 };
+    // signaling with --cycles: where the cycle starts and its period, 0 if none was found,
+    // and the steps fast-forwarded over, which steps does not count
+    std::uint64_t cycle_onset { 0 };
+    std::uint64_t cycle_period { 0 };
+    unsigned long skipped { 0 };
+
+    inline double steps_per_second() const
+    {
+        return (seconds > 0) ? steps / seconds : 0;
+    }
+};
+
+
+void usage(const char * name)
+{
+    std::cerr
+        << "usage: " << name << " [options]\n"
+        << "  --size N | XxYxZ      grid size (default 128)\n"
+        << "  --seed N              seed for the network (default random)\n"
+        << "  --growth-steps N      stop growing after N steps, 0 until it converges (default 0)\n"
+        << "  --signal-steps N      signaling steps once grown (default 1000)\n"
+        << "  --threads N           worker threads (default all cores)\n"
+        << "  --growth full|frontier growth engine (default frontier)\n"
+        << "  --huge-pages          back the grid with huge pages\n"
+        << "  --packed              bit-packed cells, less than half the memory\n"
+        << "  --tile-steps K        fuse K signaling steps into one pass over the grid (default 1)\n"
+        << "  --ranks N             split the grid in z over N processes on this machine (default 1)\n"
+        << "  --transport socket|shm|mpi  how the processes exchange faces (default socket),\n"
+        << "                        mpi takes the processes mpirun started (make MPI=1)\n"
+        << "  --format text|csv     report format (default text)\n"
+        << "  --output FILE         append the report to FILE instead of stdout\n"
+        << "  --load FILE           start from a snapshot instead of a new network\n"
+        << "  --save FILE           snapshot the network once grown\n"
+        << "  --stats FILE          dump counters to FILE (needs make INSTRUMENT=1)\n"
+        << "  --stats-every N       steps between dumps (default 100)\n"
+        << "  --stats-format json|csv  (default json)\n"
+        << "  --render ppm:PREFIX | raw:FILE | pipe:COMMAND  write frames of the slice x = X,\n"
+        << "                        as the window shows it, see frame_sink.hpp\n"
+        << "  --render-every N      steps between frames (default 1)\n"
+        << "  --render-slice X      (default 0)\n"
+        << "  --record FILE         record the signaling steps to FILE, see spike_raster.hpp\n"
+        << "  --record-kind firings|activity  neurons that fired, or all cells carrying a signal\n"
+        << "                        (default firings)\n"
+        << "  --record-every N      signaling steps between recorded ones (default 1)\n"
+        << "  --cycles detect|stop|skip  find where signaling repeats itself, and then step on,\n"
+        << "                        stop, or skip the whole cycles left, see cycle_detector.hpp\n"
+        << "  --cycle-every N       steps between hashes until the cycle is found (default 16)\n"
+        << "  --rules " << compiled_rules::names() << "\n"
+        << "                        the numbers in the rules, see cell_rules.hpp (default codi)\n";
+}
+
+
+bool parse_size(const std::string & s, run_options & o)
+{
+    char x1 { 0 }, x2 { 0 }, rest { 0 };
+
+    if(std::sscanf(s.c_str(), "%d%c%d%c%d%c", &o.size_x, &x1, &o.size_y, &x2, &o.size_z, &rest) == 5) {
+        return x1 == 'x' && x2 == 'x';
+    }
+
+    if(std::sscanf(s.c_str(), "%d%c", &o.size_x, &rest) == 1) {
+        o.size_y = o.size_z = o.size_x;
+        return true;
+    }
+
+    return false;
+}
+
+
+/* Only checks that there is a rule set of that name.
+ */
+struct rules_known
+{
+    template <typename Rules>
+    void operator()(Rules) { }
+};
+
+
+bool parse_options(int argc, char ** argv, run_options & o)
+{
+    rules_known known;
+
+    for(int i=1; i<argc; ++i) {
+        const std::string arg { argv[i] };
+        const bool has_value = i + 1 < argc;
+        const std::string value { has_value ? argv[i + 1] : "" };
+
+        if(arg == "--huge-pages") {
+            o.huge_pages = true;
+            continue;
+        }
+
+        if(arg == "--packed") {
+            o.packed = true;
+            continue;
+        }
+
+        if(!has_value) {
+            return false;
+        }
+
+        ++i;
+        if(arg == "--size") {
+            if(!parse_size(value, o)) {
+                return false;
+            }
+        } else if(arg == "--seed") {
+            o.seeded = true;
+            o.seed = std::strtoull(value.c_str(), nullptr, 0);
+        } else if(arg == "--growth-steps") {
+            o.growth_steps = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--signal-steps") {
+            o.signal_steps = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--threads") {
+            o.threads = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--growth" && (value == "full" || value == "frontier")) {
+            o.grower = (value == "full") ? growth_engine::FULL_SCAN : growth_engine::FRONTIER;
+        } else if(arg == "--format" && (value == "text" || value == "csv")) {
+            o.format = value;
+        } else if(arg == "--output") {
+            o.output = value;
+        } else if(arg == "--load") {
+            o.load = value;
+        } else if(arg == "--save") {
+            o.save = value;
+        } else if(arg == "--tile-steps") {
+            o.tile_steps = std::strtol(value.c_str(), nullptr, 0);
+        } else if(arg == "--ranks") {
+            o.ranks = std::strtol(value.c_str(), nullptr, 0);
+        } else if(arg == "--transport" && (value == "socket" || value == "shm" || (mpi_built && value == "mpi"))) {
+            o.transport = value;
+        } else if(arg == "--stats") {
+            o.stats = value;
+        } else if(arg == "--stats-every") {
+            o.stats_every = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--stats-format" && (value == "json" || value == "csv")) {
+            o.stats_format = value;
+        } else if(arg == "--render") {
+            o.render = value;
+        } else if(arg == "--render-every") {
+            o.render_every = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--render-slice") {
+            o.render_slice = std::strtol(value.c_str(), nullptr, 0);
+        } else if(arg == "--record") {
+            o.record = value;
+        } else if(arg == "--record-kind" && (value == "firings" || value == "activity")) {
+            o.record_kind = (value == "firings") ? RASTER_FIRINGS : RASTER_ACTIVITY;
+        } else if(arg == "--record-every") {
+            o.record_every = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--cycles" && (value == "detect" || value == "stop" || value == "skip")) {
+            o.cycles = value;
+        } else if(arg == "--cycle-every") {
+            o.cycle_every = std::strtoul(value.c_str(), nullptr, 0);
+        } else if(arg == "--rules" && compiled_rules::dispatch(value, known)) {
+            o.rules = value;
+        } else {
+            return false;
+        }
+    }
+
+    // a packed network has no snapshots or counters, and only the default rules
+    if(o.packed && (!o.load.empty() || !o.save.empty() || !o.stats.empty() || o.rules != codi_rules::name())) {
+        return false;
+    }
+
+    // fused steps only end every K steps, the packed network has none
+    if(o.tile_steps > 1 && (o.packed || !o.stats.empty() || !o.render.empty() || !o.record.empty())) {
+        return false;
+    }
+
+    // hashed are the planes of a network; what watches every step would miss the skipped ones
+    if(!o.cycles.empty() && (o.packed || o.tile_steps > 1
+                             || (o.cycles != "detect" && (!o.stats.empty() || !o.render.empty() || !o.record.empty())))) {
+        return false;
+    }
+
+    // the slabs only come together for the report, and run the default rules
+    if((o.ranks > 1 || o.transport == "mpi") && (o.packed || o.tile_steps > 1 || !o.load.empty() || !o.save.empty() || !o.stats.empty()
+                                               || !o.render.empty() || !o.record.empty() || !o.cycles.empty()
+                                               || o.rules != codi_rules::name())) {
+        return false;
+    }
+
+    return o.size_x > 0 && o.size_y > 0 && o.size_z > 0 && o.stats_every > 0 && o.render_every > 0
+        && o.record_every > 0 && o.cycle_every > 0 && o.ranks > 0 && o.ranks <= o.size_z;
+}
+
+
+/* Writes nw.stats() every stats_every steps, and at the end.
+ */
+class stats_dump
+{
+private:
+    std::ofstream out;
+    bool csv;
+    unsigned long every;
+    std::uint64_t steps;
+    bool header;
+
+public:
+    explicit stats_dump(const run_options & o) :
+        csv(o.stats_format == "csv"),
+        every(o.stats_every),
+        steps(0),
+        header(true)
+    {
+        if(o.stats.empty()) {
+            return;
+        }
+
+        if(!instrumented) {
+            std::cerr << "--stats: built without instrumentation, all counters are 0 (make INSTRUMENT=1)" << std::endl;
+        }
+
+        out.open(o.stats);
+        if(!out) {
+            std::cerr << "could not write " << o.stats << std::endl;
+        }
+    }
+
+    template <typename Network>
+    void write(const Network & nw)
+    {
+        if(!out.is_open()) {
+            return;
+        }
+
+        if(csv) {
+            nw.stats().write_csv(out, steps, nw, header);
+            header = false;
+        } else {
+            nw.stats().write_json(out, steps, nw);
+        }
+    }
+
+    template <typename Network>
+    void step(const Network & nw)
+    {
+        if(++steps % every == 0) {
+            write(nw);
+        }
+    }
+
+    template <typename Network>
+    void finish(const Network & nw)
+    {
+        if(steps % every != 0) {
+            write(nw);
+        }
+    }
+};
+
+
+/* Writes a frame of the slice every render_every steps, and of the network as it starts.
+ */
+class frame_dump
+{
+private:
+    std::unique_ptr<slice_renderer> renderer;
+    std::unique_ptr<frame_sink> sink;
+    unsigned long every;
+    std::uint64_t steps;
+
+public:
+    template <typename Network>
+    frame_dump(const run_options & o, const Network & nw) :
+        every(o.render_every),
+        steps(0)
+    {
+        if(o.render.empty()) {
+            return;
+        }
+
+        if(o.render_slice < 0 || o.render_slice >= nw.size_x()) {
+            throw std::invalid_argument("--render-slice: no slice x = " + std::to_string(o.render_slice));
+        }
+
+        renderer.reset(new slice_renderer(nw.size_y(), nw.size_z(), o.render_slice));
+        sink.reset(new frame_sink(o.render));
+    }
+
+    template <typename Network>
+    void write(const Network & nw)
+    {
+        if(!sink) {
+            return;
+        }
+
+        renderer->update(nw);
+        sink->write(*renderer);
+    }
+
+    template <typename Network>
+    void step(const Network & nw)
+    {
+        if(++steps % every == 0) {
+            write(nw);
+        }
+    }
+};
+
+
+/* Records the signaling steps if asked to, see raster_recorder.
+ */
+class raster_dump
+{
+private:
+    std::unique_ptr<raster_recorder> recorder;
+
+public:
+    template <typename Network>
+    raster_dump(const run_options & o, const Network & nw)
+    {
+        if(!o.record.empty()) {
+            recorder.reset(new raster_recorder(o.record, nw.size_x(), nw.size_y(), nw.size_z(), o.record_kind, o.record_every));
+        }
+    }
+
+    template <typename Network>
+    void step(const Network & nw)
+    {
+        if(recorder) {
+            recorder->record(nw);
+        }
+    }
+
+    void finish()
+    {
+        if(recorder) {
+            recorder->finish();
+        }
+    }
+};
+
+
+template <typename F>
+double seconds_of(F f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+template <typename Network>
+std::uint64_t live_cells(const Network & nw)
+{
+    std::uint64_t live { 0 };
+
+    for(int iz=0; iz<nw.size_z(); ++iz) {
+        for(int iy=0; iy<nw.size_y(); ++iy) {
+            for(int ix=0; ix<nw.size_x(); ++ix) {
+                live += (nw.type(iz, iy, ix) != BLANK) ? 1 : 0;
+            }
+        }
+    }
+
+    return live;
+}
+
+/* live counts the whole network, which nw may only hold a slab of.
+ */
+template <typename Network>
+void write_report(std::ostream & out, const run_options & o, const Network & nw, const std::uint64_t live,
+                  const phase_report & growth, const phase_report & signaling, const bool header)
+{
+    const double cells = static_cast<double>(nw.size_x()) * nw.size_y() * nw.size_z();
+
+    if(o.format == "csv") {
+        if(header) {
+            out << "size_x,size_y,size_z,seed,threads,live_cells,converged,"
+                << "growth_steps,growth_seconds,growth_steps_per_sec,growth_cell_updates_per_sec,"
+                << "signal_steps,signal_seconds,signal_steps_per_sec,signal_cell_updates_per_sec,"
+                << "cycle_onset,cycle_period,skipped_steps,rules\n";
+        }
+
+        out << nw.size_x() << ',' << nw.size_y() << ',' << nw.size_z() << ','
+            << o.seed << ',' << nw.threads() << ',' << live << ',' << (nw.growing() ? 0 : 1) << ','
+            << growth.steps << ',' << growth.seconds << ','
+            << growth.steps_per_second() << ',' << growth.steps_per_second() * cells << ','
+            << signaling.steps << ',' << signaling.seconds << ','
+            << signaling.steps_per_second() << ',' << signaling.steps_per_second() * cells << ',';
+        if(signaling.cycle_period != 0) {
+            out << signaling.cycle_onset << ',' << signaling.cycle_period;
+        } else {
+            out << ',';
+        }
+        out << ',' << signaling.skipped << ',' << o.rules << '\n';
+        return;
+    }
+
+    out << "grid        " << nw.size_x() << 'x' << nw.size_y() << 'x' << nw.size_z()
+        << ", seed " << o.seed << ", " << nw.threads() << " threads"
+        << (o.rules != codi_rules::name() ? ", rules " + o.rules : "") << '\n'
+        << "live cells  " << live << (nw.growing() ? " (still growing)" : "") << '\n'
+        << "growth      " << growth.steps << " steps in " << growth.seconds << " s, "
+        << growth.steps_per_second() << " steps/s, "
+        << growth.steps_per_second() * cells << " cell-updates/s\n"
+        << "signaling   " << signaling.steps << " steps in " << signaling.seconds << " s, "
+        << signaling.steps_per_second() << " steps/s, "
+        << signaling.steps_per_second() * cells << " cell-updates/s\n";
+
+    if(signaling.cycle_period != 0) {
+        out << "cycle       period " << signaling.cycle_period << " from step " << signaling.cycle_onset;
+        if(signaling.skipped != 0) {
+            out << ", " << signaling.skipped << " steps skipped";
+        }
+        out << '\n';
+    } else if(!o.cycles.empty()) {
+        out << "cycle       none found\n";
+    }
+}
+
+
+template <typename Network, typename Observer>
+void grow(Network & nw, const run_options & o, phase_report & growth, Observer step_done)
+{
+    growth.seconds = seconds_of([&] {
+        while(nw.growing() && (o.growth_steps == 0 || growth.steps < o.growth_steps)) {
+            nw.step_ca();
+            ++growth.steps;
+            step_done(nw);
+        }
+    });
+}
+
+/* Only a basic_network fuses steps, see set_temporal_tiling.
+ */
+template <typename Network>
+void fused_steps(Network & nw, const unsigned long steps)
+{
+    for(unsigned long n=0; n<steps; ++n) {
+        nw.step_ca();
+    }
+}
+
+template <typename Extent, typename Rules>
+void fused_steps(basic_network<Extent, Rules> & nw, const unsigned long steps)
+{
+    nw.step_ca(steps);
+}
+
+/* Only networks with their planes in grid are hashed, see cycle_detector;
+ * parse_options keeps --cycles away from the others.
+ */
+template <typename Network, typename Observer>
+void cycle_steps(Network &, const run_options &, phase_report &, Observer)
+{
+}
+
+template <typename Extent, typename Rules, typename Observer>
+void cycle_steps(basic_network<Extent, Rules> & nw, const run_options & o, phase_report & signaling, Observer step_done)
+{
+    const cycle_action action = (o.cycles == "stop") ? cycle_action::STOP
+                              : (o.cycles == "skip") ? cycle_action::FAST_FORWARD : cycle_action::DETECT;
+
+    cycle_detector cycles(o.cycle_every);
+    const signal_outcome outcome = signal_with_cycles(nw, o.signal_steps, cycles, action, step_done);
+
+    signaling.steps = outcome.simulated;
+    signaling.skipped = outcome.steps - outcome.simulated;
+    signaling.cycle_onset = cycles.onset();
+    signaling.cycle_period = cycles.period();
+}
+
+template <typename Network, typename Observer>
+void signal(Network & nw, const run_options & o, phase_report & signaling, Observer step_done)
+{
+    // signaling only starts on a converged network
+    if(nw.growing()) {
+        return;
+    }
+
+    nw.prepare_signaling();
+
+    signaling.seconds = seconds_of([&] {
+        if(o.tile_steps > 1) {
+            fused_steps(nw, o.signal_steps);
+            signaling.steps = o.signal_steps;
+            return;
+        }
+
+        if(!o.cycles.empty()) {
+            cycle_steps(nw, o, signaling, step_done);
+            return;
+        }
+
+        for(; signaling.steps < o.signal_steps; ++signaling.steps) {
+            nw.step_ca();
+            step_done(nw);
+        }
+    });
+}
+
+template <typename Network>
+int report(const run_options & o, const Network & nw, const std::uint64_t live,
+           const phase_report & growth, const phase_report & signaling)
+{
+    if(o.output.empty()) {
+        write_report(std::cout, o, nw, live, growth, signaling, true);
+        return 0;
+    }
+
+    std::ofstream out { o.output, std::ios::app };
+    const bool header = out.tellp() == 0;
+
+    write_report(out, o, nw, live, growth, signaling, header);
+    if(!out) {
+        std::cerr << "could not write " << o.output << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/* --ranks N: forks N-1 more processes, each runs a slab of the grid,
+ * and rank 0 reports on the counts added up from all of them.
+ * With --transport mpi the processes are the ones mpirun started instead.
+ * A rank that fails aborts the link, so the others fail too instead of
+ * waiting on it.
+ */
+int run_distributed(const run_options & o)
+{
+    const std::string name = "/codi-" + std::to_string(getpid());
+    int rank { 0 };
+
+    for(int r=1; r<o.ranks && o.transport != "mpi"; ++r) {
+        const pid_t pid = fork();
+
+        if(pid < 0) {
+            std::cerr << "could not start rank " << r << std::endl;
+            return 1;
+        }
+        if(pid == 0) {
+            rank = r;
+            break;
+        }
+    }
+
+    phase_report growth;
+    phase_report signaling;
+    std::unique_ptr<halo_transport> link;
+    std::unique_ptr<distributed_network> nw;
+    std::uint64_t live { 0 };
+
+    try {
+        if(o.transport == "mpi") {
+#ifdef CODI_MPI
+            link.reset(new mpi_transport());
+            rank = link->rank();
+#endif
+        } else if(o.transport == "shm") {
+            // a face each way and the growth votes, with a step of slack
+            const std::size_t face = static_cast<std::size_t>(o.size_x) * o.size_y;
+            link.reset(new shm_transport(name, rank, o.ranks, 2 * face + 4096));
+        } else {
+            link.reset(new socket_transport("/tmp" + name, rank, o.ranks));
+        }
+
+        nw.reset(new distributed_network(dynamic_extent(o.size_x, o.size_y, o.size_z, o.huge_pages), o.seed, *link));
+        nw->set_threads(o.threads);
+
+        const auto nothing = [](const distributed_network &) { };
+        grow(*nw, o, growth, nothing);
+        signal(*nw, o, signaling, nothing);
+        live = nw->live_cells();
+    } catch(const std::exception & e) {
+        std::cerr << "rank " << rank << ": " << e.what() << std::endl;
+        if(link) {
+            link->abort();
+        }
+        return 1;
+    }
+
+    if(rank != 0) {
+        return 0;
+    }
+
+    int failed { 0 };
+    for(int status { 0 }; wait(&status) > 0; ) {
+        failed += (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+    }
+
+    if(failed != 0) {
+        std::cerr << failed << " ranks failed" << std::endl;
+        return 1;
+    }
+
+    return report(o, *nw, live, growth, signaling);
+}
+
+
+/* A basic_network, new or loaded, with the rules picked by --rules.
+ */
+template <typename Network>
+int run_network_of(run_options & o)
+{
+    phase_report growth;
+    phase_report signaling;
+    std::unique_ptr<Network> loaded;
+
+    if(!o.load.empty()) {
+        try {
+            loaded = snapshot_view(o.load).load<Network>(o.huge_pages);
+        } catch(const std::exception & e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        o.seed = loaded->seed();
+    } else {
+        loaded.reset(new Network(dynamic_extent(o.size_x, o.size_y, o.size_z, o.huge_pages), o.seed));
+    }
+
+    Network & nw = *loaded;
+    nw.set_threads(o.threads);
+    nw.set_growth_engine(o.grower);
+    nw.set_temporal_tiling(o.tile_steps);
+
+    stats_dump stats(o);
+
+    try {
+        frame_dump frames(o, nw);
+        raster_dump raster(o, nw);
+        const auto dump = [&](const Network & n) {
+            stats.step(n);
+            frames.step(n);
+        };
+        const auto dump_and_record = [&](const Network & n) {
+            dump(n);
+            raster.step(n);
+        };
+
+        frames.write(nw);
+        grow(nw, o, growth, dump);
+
+        if(!o.save.empty()) {
+            save_snapshot(nw, o.save, snapshot_options(false));
+        }
+
+        signal(nw, o, signaling, dump_and_record);
+        raster.finish();
+    } catch(const std::exception & e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    stats.finish(nw);
+
+    return report(o, nw, live_cells(nw), growth, signaling);
+}
+
+/* Runs run_network_of with a rule set from compiled_rules::dispatch.
+ */
+struct run_network
+{
+    run_options & o;
+    int status;
+
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        status = run_network_of<basic_network<dynamic_extent, Rules>>(o);
+    }
+};
+
+
+int main(int argc, char ** argv)
+{
+    run_options o;
+
+    if(!parse_options(argc, argv, o)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(!o.seeded) {
+        o.seed = random_seed();
+    }
+
+    phase_report growth;
+    phase_report signaling;
+
+    if(o.transport == "mpi") {
+#ifdef CODI_MPI
+        MPI_Init(&argc, &argv);
+        const int status = run_distributed(o);
+        MPI_Finalize();
+        return status;
+#endif
+    }
+
+    if(o.ranks > 1) {
+        return run_distributed(o);
+    }
+
+    if(o.packed) {
+        packed_network nw(dynamic_extent(o.size_x, o.size_y, o.size_z, o.huge_pages), o.seed);
+        nw.set_threads(o.threads);
+
+        try {
+            frame_dump frames(o, nw);
+            raster_dump raster(o, nw);
+            const auto render = [&](const packed_network & n) { frames.step(n); };
+            const auto render_and_record = [&](const packed_network & n) {
+                frames.step(n);
+                raster.step(n);
+            };
+
+            frames.write(nw);
+            grow(nw, o, growth, render);
+            signal(nw, o, signaling, render_and_record);
+            raster.finish();
+        } catch(const std::exception & e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        return report(o, nw, live_cells(nw), growth, signaling);
+    }
+
+    run_network run { o, 1 };
+    compiled_rules::dispatch(o.rules, run);
+    return run.status;
+}
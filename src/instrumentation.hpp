@@ -0,0 +1,305 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include "aligned_buffer.hpp"
+#include "cell_type.hpp"
+#include "signal_kernel.hpp"
+
+
+/* Counters and timers in the step loop, for watching growth converge and
+ * catching regressions. Build with -DCODI_INSTRUMENT=1 (make INSTRUMENT=1)
+ * to turn them on; otherwise every call below is empty and compiles away.
+ */
+#ifndef CODI_INSTRUMENT
+#define CODI_INSTRUMENT 0
+#endif
+
+constexpr bool instrumented = CODI_INSTRUMENT != 0;
+
+
+enum class step_phase : std::uint8_t {
+    GROWTH,
+    SIGNAL,
+    KICK,
+    SETUP_SIGNALING
+};
+
+constexpr int step_phases = 4;
+
+inline const char * phase_name(const int p)
+{
+    static const char * const names[step_phases] = { "growth", "signal", "kick", "setup_signaling" };
+    return names[p];
+}
+
+
+/* What one worker saw, one cache line each so workers never share one;
+ * instrumentation keeps them in a cache line aligned buffer.
+ */
+struct alignas(64) worker_counters
+{
+    std::uint64_t grown_neurons;
+    std::uint64_t grown_axons;
+    std::uint64_t grown_dendrites;
+    std::uint64_t fired;            // neuron firings
+    std::uint64_t active_axons;     // axon cells carrying a spike, summed over steps
+    std::uint64_t active_dendrites;
+
+    inline void grew(const cell_type type)
+    {
+        if(!instrumented) {
+            return;
+        }
+
+        grown_neurons   += (type == NEURON) ? 1 : 0;
+        grown_axons     += (type == AXON) ? 1 : 0;
+        grown_dendrites += (type == DENDRITE) ? 1 : 0;
+    }
+
+    /* Counts what the signaling kernels left in [begin, end): a neuron
+     * fired iff its activation was reset to 0, axons and dendrites flag
+     * a signal with activation 1.
+     */
+    inline void signaled(const cell_type * type, const std::uint8_t * activation, const std::size_t begin, const std::size_t end)
+    {
+        if(!instrumented) {
+            return;
+        }
+
+        std::size_t i = begin;
+
+#if defined(__x86_64__) || defined(__i386__)
+        // byte counters in 16 lanes, emptied before they can wrap
+        while(i + 16 <= end) {
+            const u8x16 zero = { };
+            u8x16 f = zero, a = zero, d = zero;
+
+            for(int n=0; n<255 && i + 16 <= end; ++n, i += 16) {
+                u8x16 t, act;
+                simd_load(t, reinterpret_cast<const std::uint8_t *>(type) + i);
+                simd_load(act, activation + i);
+
+                const u8x16 on = reinterpret_cast<u8x16>(act != 0);
+                f -= reinterpret_cast<u8x16>(t == static_cast<std::uint8_t>(NEURON)) & ~on;
+                a -= reinterpret_cast<u8x16>(t == static_cast<std::uint8_t>(AXON)) & on;
+                d -= reinterpret_cast<u8x16>(t == static_cast<std::uint8_t>(DENDRITE)) & on;
+            }
+
+            for(int n=0; n<16; ++n) {
+                fired += f[n];
+                active_axons += a[n];
+                active_dendrites += d[n];
+            }
+        }
+#endif
+
+        for(; i<end; ++i) {
+            const bool on = activation[i] != 0;
+            fired            += (type[i] == NEURON && !on) ? 1 : 0;
+            active_axons     += (type[i] == AXON && on) ? 1 : 0;
+            active_dendrites += (type[i] == DENDRITE && on) ? 1 : 0;
+        }
+    }
+};
+
+static_assert(sizeof(worker_counters) == 64 && alignof(worker_counters) == 64, "one cache line per worker");
+
+
+class instrumentation
+{
+private:
+    std::array<double, step_phases> seconds;
+    std::array<std::uint64_t, step_phases> calls;
+    aligned_buffer<worker_counters> workers;
+    std::uint64_t frontier_last;
+    std::uint64_t frontier_peak;
+    std::uint64_t grown_last;
+
+public:
+    instrumentation() :
+        workers(1, false)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        seconds.fill(0);
+        calls.fill(0);
+        for(worker_counters & w : workers) {
+            w = worker_counters();
+        }
+
+        frontier_last = 0;
+        frontier_peak = 0;
+        grown_last = 0;
+    }
+
+    /* Keeps the counts of the workers so far.
+     */
+    void set_workers(const unsigned n)
+    {
+        if(n > workers.size()) {
+            aligned_buffer<worker_counters> more(n, false);
+
+            std::copy(workers.begin(), workers.end(), more.begin());
+            std::fill(more.begin() + workers.size(), more.end(), worker_counters());
+            workers = std::move(more);
+        }
+    }
+
+    inline worker_counters & worker(const unsigned w)
+    {
+        return workers[w];
+    }
+
+    /* A frontier growth step looked at `cells` blank cells, `grown` of which grew.
+     */
+    inline void frontier(const std::size_t cells, const std::size_t grown)
+    {
+        if(!instrumented) {
+            return;
+        }
+
+        frontier_last = cells;
+        frontier_peak = (cells > frontier_peak) ? cells : frontier_peak;
+        grown_last = grown;
+    }
+
+    inline void add_time(const step_phase p, const double s)
+    {
+        seconds[static_cast<int>(p)] += s;
+        ++calls[static_cast<int>(p)];
+    }
+
+
+    /* Adds its lifetime to phase p.
+     */
+    class timer
+    {
+    private:
+        instrumentation & stats;
+        step_phase p;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        timer(instrumentation & s, const step_phase phase) :
+            stats(s),
+            p(phase)
+        {
+            if(instrumented) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~timer()
+        {
+            if(instrumented) {
+                stats.add_time(p, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+
+        timer(const timer &) = delete;
+        timer & operator=(const timer &) = delete;
+    };
+
+
+    inline double phase_seconds(const step_phase p) const
+    {
+        return seconds[static_cast<int>(p)];
+    }
+
+    inline std::uint64_t phase_calls(const step_phase p) const
+    {
+        return calls[static_cast<int>(p)];
+    }
+
+    worker_counters total() const
+    {
+        worker_counters sum = worker_counters();
+
+        for(const worker_counters & w : workers) {
+            sum.grown_neurons    += w.grown_neurons;
+            sum.grown_axons      += w.grown_axons;
+            sum.grown_dendrites  += w.grown_dendrites;
+            sum.fired            += w.fired;
+            sum.active_axons     += w.active_axons;
+            sum.active_dendrites += w.active_dendrites;
+        }
+
+        return sum;
+    }
+
+
+    /* One JSON object per line: the step it was taken at, the cell types
+     * of nw now, and the counters and phase times since the start or reset().
+     */
+    template <typename Network>
+    void write_json(std::ostream & out, const std::uint64_t step, const Network & nw) const
+    {
+        const worker_counters sum = total();
+        std::array<std::uint64_t, 5> types {{ }};
+
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            ++types[nw.grid.type[i]];
+        }
+
+        out << "{\"step\":" << step << ",\"growing\":" << (nw.growing() ? "true" : "false")
+            << ",\"cells\":{\"blank\":" << types[BLANK] << ",\"neuron\":" << types[NEURON]
+            << ",\"axon\":" << types[AXON] << ",\"dendrite\":" << types[DENDRITE] << '}'
+            << ",\"grown\":{\"neuron\":" << sum.grown_neurons << ",\"axon\":" << sum.grown_axons
+            << ",\"dendrite\":" << sum.grown_dendrites << '}'
+            << ",\"frontier\":{\"last\":" << frontier_last << ",\"peak\":" << frontier_peak
+            << ",\"grown_last\":" << grown_last << '}'
+            << ",\"fired\":" << sum.fired << ",\"active_axons\":" << sum.active_axons
+            << ",\"active_dendrites\":" << sum.active_dendrites
+            << ",\"phases\":{";
+
+        for(int p=0; p<step_phases; ++p) {
+            out << (p ? "," : "") << '"' << phase_name(p) << "\":{\"calls\":" << calls[p] << ",\"seconds\":" << seconds[p] << '}';
+        }
+
+        out << "}}\n";
+    }
+
+    /* The same as write_json, one row per dump.
+     */
+    template <typename Network>
+    void write_csv(std::ostream & out, const std::uint64_t step, const Network & nw, const bool header) const
+    {
+        const worker_counters sum = total();
+        std::array<std::uint64_t, 5> types {{ }};
+
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            ++types[nw.grid.type[i]];
+        }
+
+        if(header) {
+            out << "step,growing,blank,neuron,axon,dendrite,grown_neuron,grown_axon,grown_dendrite,"
+                << "frontier_last,frontier_peak,grown_last,fired,active_axons,active_dendrites";
+            for(int p=0; p<step_phases; ++p) {
+                out << ',' << phase_name(p) << "_calls," << phase_name(p) << "_seconds";
+            }
+            out << '\n';
+        }
+
+        out << step << ',' << (nw.growing() ? 1 : 0) << ','
+            << types[BLANK] << ',' << types[NEURON] << ',' << types[AXON] << ',' << types[DENDRITE] << ','
+            << sum.grown_neurons << ',' << sum.grown_axons << ',' << sum.grown_dendrites << ','
+            << frontier_last << ',' << frontier_peak << ',' << grown_last << ','
+            << sum.fired << ',' << sum.active_axons << ',' << sum.active_dendrites;
+        for(int p=0; p<step_phases; ++p) {
+            out << ',' << calls[p] << ',' << seconds[p];
+        }
+        out << '\n';
+    }
+};
+
+#endif
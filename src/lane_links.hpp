@@ -0,0 +1,69 @@
+#ifndef LANE_LINKS_H
+#define LANE_LINKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "cell.hpp"
+#include "cell_type.hpp"
+#include "network.hpp"
+
+
+/* How signals get from one live cell to another in the signaling phase.
+ * BLANK cells never touch their iobuf, so a value put into lane d moves
+ * one cell per kick in a straight line until a live cell reads it
+ * (or it leaves the grid). The helpers below follow such a line.
+ */
+
+
+/* Axons only listen to their gate, neurons ignore the lanes along their axon.
+ */
+inline bool reads_lane(const cell_type type, const std::uint8_t gate, const int dir)
+{
+    switch(type) {
+        case AXON:   return dir == gate;
+        case NEURON: return dir != gate && dir != cell::adjacent_gate(gate);
+        default:     return true;
+    }
+}
+
+
+/* Walks from cell i against the flow of lane dir, calling f(index) for i
+ * and every blank cell on the way.
+ * Returns the index of the live cell it stops at, or -1 at the border.
+ */
+template <typename Network, typename F>
+inline std::ptrdiff_t walk_lane(const Network & nw, const int dir, std::size_t i, F f)
+{
+    f(i);
+
+    while(nw.lane_source(dir, i, i)) {
+        if(nw.grid.type[i] != BLANK) {
+            return i;
+        }
+
+        f(i);
+    }
+
+    return -1;
+}
+
+/* Follows what cell i puts into lane dir to the live cell that gets it.
+ * Returns that cell's index and its distance in steps, or -1 at the border.
+ */
+template <typename Network>
+inline std::ptrdiff_t trace_lane(const Network & nw, const int dir, std::size_t i, std::uint32_t & distance)
+{
+    distance = 0;
+
+    while(nw.lane_target(dir, i, i)) {
+        ++distance;
+
+        if(nw.grid.type[i] != BLANK) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+#endif
@@ -1,301 +1,970 @@
 #ifndef NETWORK_H
 #define NETWORK_H
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bitset>
 #include <numeric>
 #include <random>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include "config.hpp"
 #include "cell.hpp"
+#include "cell_rules.hpp"
+#include "cell_planes.hpp"
+#include "cell_rng.hpp"
 #include "cell_type.hpp"
+#include "grid_extent.hpp"
+#include "instrumentation.hpp"
+#include "signal_kernel.hpp"
 #include "utility.hpp"
+#include "worker_pool.hpp"
 
 
+/* How growth_step finds the cells to update.
+ * FULL_SCAN visits every cell and kicks the planes, the reference;
+ * FRONTIER only visits the blank cells whose inputs changed, with the same result.
+ */
+enum class growth_engine : std::uint8_t {
+    FULL_SCAN,
+    FRONTIER
+};
+
 
-/* CoDi is a cellular automaton (CA) model for spiking neural networks (SNNs). 
- * CoDi is an acronym for Collect and Distribute, 
+/* CoDi is a cellular automaton (CA) model for spiking neural networks (SNNs).
+ * CoDi is an acronym for Collect and Distribute,
  * referring to the signals and spikes in a neural network.
- * 
+ *
  * CoDi uses a von Neumann neighborhood modified for a three-dimensional space
- * each cell looks at the states of its six orthogonal neighbors(EWNSUD) and its own state. 
+ * each cell looks at the states of its six orthogonal neighbors(EWNSUD) and its own state.
  * Signals are distributed from the neuron bodies via their axon tree and collected from connection dendrites.
  * These two basic interactions cover every case, and they can be expressed simply, using a small number of rules.
+ *
+ * The grid is x by y by z cells as given by the Extent, see grid_extent.hpp,
+ * and the numbers in the rules are those of a rule_set, see cell_rules.hpp.
  */
-template <int GSize>
-class network
+template <typename Extent, typename Rules = codi_rules>
+class basic_network
 {
 private:
+    Extent extent;
+    std::uint64_t network_seed;
     bool changed;
     bool has_setup_signaling;
+    std::unique_ptr<worker_pool> workers;
+    signal_kernel kernel;
+    growth_engine grower;
+
+    // blank cells to look at in the next frontier growth step
+    std::vector<std::size_t> frontier;
+    std::vector<std::size_t> grown_cells;
+    std::vector<std::uint8_t> queued;
+    bool frontier_valid;
+
+    instrumentation counters;
+
+    // signaling steps fused by step_ca(n), see set_temporal_tiling
+    int tile_steps;
+
+
+    typedef std::array<std::uint8_t *, 6> lane_pointers;
+
+    inline lane_pointers lanes()
+    {
+        return {{
+            grid.iobuf[0].data(), grid.iobuf[1].data(), grid.iobuf[2].data(),
+            grid.iobuf[3].data(), grid.iobuf[4].data(), grid.iobuf[5].data()
+        }};
+    }
+
+    inline static void iobuf_fill(const lane_pointers & io, const std::size_t i, const std::uint8_t v)
+    {
+        for(int d=0; d<6; ++d) {
+            io[d][i] = v;
+        }
+    }
+
+    inline static std::array<std::uint8_t, 6> iobuf_of(const lane_pointers & io, const std::size_t i)
+    {
+        return {{ io[0][i], io[1][i], io[2][i], io[3][i], io[4][i], io[5][i] }};
+    }
+
+    inline static std::uint8_t iobuf_sum(const lane_pointers & io, const std::size_t i)
+    {
+        int sum { 0 };
+        for(int d=0; d<6; ++d) {
+            sum += io[d][i];
+        }
+        return sum;
+    }
+
+
+    /* Runs kernel(worker, begin, end) over the linear cell range of the whole grid.
+     * With a worker pool the grid is split into z-slabs, one per worker;
+     * every cell update only reads its own iobuf, so the slabs are independent
+     * until the next kick.
+     */
+    template <typename Kernel>
+    void for_each_slab(Kernel kernel)
+    {
+        if(!workers) {
+            kernel(0, 0, volume());
+            return;
+        }
+
+        workers->run(extent.z(), [&](const unsigned worker, const std::size_t z_begin, const std::size_t z_end) {
+            kernel(worker, index(z_begin, 0, 0), index(z_end, 0, 0));
+        });
+    }
 
 
     /* For the Neighborhood interaction.
      * Names for the buffer correspond to the I-Buf,
      * so where the Information (signal) came from;
      * e.g. in the north buffer (+y=2) of a cell is either what came
-     * from the north (after kick) or the what will go to the south 
+     * from the north (after kick) or the what will go to the south
      * (before kick).
      * iobuf[0..5] = east(+x), west(-x), north(+y), south(-y),
-     * top(+z), bottom(-z) 
+     * top(+z), bottom(-z)
      * actualize the 3 direction one at a time, without wrap-around.
      */
     void kicking()
     {
+        const instrumentation::timer timer(counters, step_phase::KICK);
+        constexpr std::ptrdiff_t x_stride = 1;
+        const int nx = extent.x();
+        const int ny = extent.y();
+        const std::ptrdiff_t y_stride = nx;
+        const std::ptrdiff_t z_stride = static_cast<std::ptrdiff_t>(nx) * ny;
+
+        // Every lane is a pure shift of its plane, so move the plane window
+        grid.iobuf[0].slide(x_stride);
+        grid.iobuf[1].slide(-x_stride);
+        grid.iobuf[2].slide(y_stride);
+        grid.iobuf[3].slide(-y_stride);
+        grid.iobuf[4].slide(z_stride);
+        grid.iobuf[5].slide(-z_stride);
+
+        clear_faces();
+    }
 
-        // For the positive directions
-        for(int iz=0; iz<GSize; ++iz) {
-            for(int iy=0; iy<GSize; ++iy) {
-                for(int ix=0; ix<GSize; ++ix) {
-                    grid[iz][iy][ix].iobuf[4] = (iz != GSize-1) ? grid[iz+1][iy][ix].iobuf[4] : 0;
-                    grid[iz][iy][ix].iobuf[2] = (iy != GSize-1) ? grid[iz][iy+1][ix].iobuf[2] : 0;
-                    grid[iz][iy][ix].iobuf[0] = (ix != GSize-1) ? grid[iz][iy][ix+1].iobuf[0] : 0;
-                }
+    /* Clears the face of each lane that came in from outside the grid.
+     */
+    void clear_faces()
+    {
+        const int nx = extent.x();
+        const int ny = extent.y();
+        const int nz = extent.z();
+        const std::size_t z_stride = static_cast<std::size_t>(nx) * ny;
+        const lane_pointers io = lanes();
+
+        for(int iz=0; iz<nz; ++iz) {
+            for(int iy=0; iy<ny; ++iy) {
+                io[0][index(iz, iy, nx-1)] = 0;
+                io[1][index(iz, iy, 0)] = 0;
             }
+
+            std::fill_n(io[2] + index(iz, ny-1, 0), nx, 0);
+            std::fill_n(io[3] + index(iz, 0, 0), nx, 0);
         }
 
-        // For the negative directions
-        for(int iz=GSize-1; iz >= 0; --iz) {
-              for(int iy=GSize-1; iy >= 0; --iy) {
-                for(int ix=GSize-1; ix >= 0; --ix) {
-                    grid[iz][iy][ix].iobuf[5] = (iz != 0) ? grid[iz-1][iy][ix].iobuf[5] : 0;
-                    grid[iz][iy][ix].iobuf[3] = (iy != 0) ? grid[iz][iy-1][ix].iobuf[3] : 0;
-                    grid[iz][iy][ix].iobuf[1] = (ix != 0) ? grid[iz][iy][ix-1].iobuf[1] : 0;
+        std::fill_n(io[4] + index(nz-1, 0, 0), z_stride, 0);
+        std::fill_n(io[5] + index(0, 0, 0), z_stride, 0);
+    }
+
+
+    /* Blanks the cells [begin, end) of every plane but chromo.
+     */
+    void clear_cells(const std::size_t begin, const std::size_t end)
+    {
+        const lane_pointers io = lanes();
+
+        std::fill_n(grid.type.data() + begin, end - begin, BLANK);
+        std::fill_n(grid.activation.data() + begin, end - begin, 0);
+        std::fill_n(grid.gate.data() + begin, end - begin, 0);
+        for(int d=0; d<6; ++d) {
+            std::fill_n(io[d] + begin, end - begin, 0);
+        }
+    }
+
+    /* A blank grid with the chromosome of network_seed. Each slab is cleared
+     * and filled in one pass, a row of chromosomes at a time, see initial_chromo_row.
+     */
+    void initialize()
+    {
+        const cell_rng rng(network_seed);
+        const std::size_t plane = static_cast<std::size_t>(extent.x()) * extent.y();
+
+        changed = true;
+        has_setup_signaling = false;
+        frontier_valid = false;
+
+        for_each_slab([&](unsigned, const std::size_t begin, const std::size_t end) {
+            clear_cells(begin, end);
+
+            for(int iz=begin / plane; iz<static_cast<int>(end / plane); ++iz) {
+                for(int iy=0; iy<extent.y(); ++iy) {
+                    initial_chromo_row(rng, iz, iy, extent.x(), grid.chromo.data() + index(iz, iy, 0));
                 }
             }
-        }
+        });
     }
 
 
     void setup_signaling()
     {
-        std::uniform_int_distribution<int> three_two_rng(0, 32);
+        const cell_rng rng(network_seed);
+        const std::size_t plane = static_cast<std::size_t>(extent.x()) * extent.y();
+        const instrumentation::timer timer(counters, step_phase::SETUP_SIGNALING);
+
         has_setup_signaling = true;
-        
-        for(int iz=0; iz<GSize; ++iz) {
-            for(int iy=0; iy<GSize; ++iy) {
-                for(int ix=0; ix<GSize; ++ix) {
-                    grid[iz][iy][ix].activation = 0;
-                    grid[iz][iy][ix].iobuf.fill(0);
-
-                    if(grid[iz][iy][ix].type == NEURON) {
-                        grid[iz][iy][ix].activation = three_two_rng(rng_gen);
+        frontier_valid = false;
+
+        // each slab clears its own part of the planes, then starts its neurons
+        for_each_slab([&](unsigned, const std::size_t begin, const std::size_t end) {
+            const lane_pointers io = lanes();
+
+            std::fill_n(grid.activation.data() + begin, end - begin, 0);
+            for(int d=0; d<6; ++d) {
+                std::fill_n(io[d] + begin, end - begin, 0);
+            }
+
+            for(int iz=begin / plane; iz<static_cast<int>(end / plane); ++iz) {
+                for(int iy=0; iy<extent.y(); ++iy) {
+                    for(int ix=0; ix<extent.x(); ++ix) {
+                        const std::size_t i = index(iz, iy, ix);
+
+                        if(grid.type[i] == NEURON) {
+                            grid.activation[i] = initial_activation(rng, iz, iy, ix);
+                        }
                     }
                 }
             }
+        });
+    }
+
+
+public:
+    /* The rules for a single cell, also used by engines that store cells differently.
+     */
+
+    /* The constraints every chromosome keeps: axons and dendrites grow along
+     * a lattice and neurons only seed on its crossings.
+     */
+    inline static std::uint8_t lattice_chromo(std::uint8_t chromo, const int iz, const int iy)
+    {
+        // restrict to grid
+        if(((iz + 1) % 2) * (iy % 2) == 1) {
+            chromo = (chromo & ~3) | 12;
+        }
+
+        if((iz % 2) * ((iy + 1) % 2) == 1) {
+            chromo = (chromo & ~12) | 3;
+        }
+
+        // Kill unwanted neuronseeds. Neuronsee only on crossings.
+        if((iz % 2) + (iy % 2) != 0) {
+            chromo &= ~192;
         }
+
+        // restrict axon-initial-growth in neuron to XY-plane.
+        if(cell::is_neuronseed(chromo)) {
+            chromo = (chromo & 192) | ((chromo & 63) % 4);
+        }
+
+        return chromo;
     }
 
+    /* The chromosome a cell starts with: random bits on the lattice.
+     */
+    inline static std::uint8_t initial_chromo(const cell_rng & rng, const int iz, const int iy, const int ix, const int size_x)
+    {
+        std::uint8_t chromo = rng(cell_rng::CHROMO, iz, iy, ix);
 
-    /* In a growth phase a neural network is grown in the CA-space based on an underlying chromosome. 
-     * The growth phase is followed by a signaling- or processing-phase
+        // Decrease prob of neuronseeds
+        if((iz % 2) + (iy % 2) == 0 && cell::is_neuronseed(chromo)) {
+            if(cell_rng::below(rng(cell_rng::NEURON_SEED, iz, iy, ix), size_x + 1) < static_cast<std::uint32_t>(size_x * Rules::seed_prune_num / Rules::seed_prune_den)) {
+                chromo &= ~192;
+            }
+        }
+
+        return lattice_chromo(chromo, iz, iy);
+    }
+
+    /* initial_chromo of the cells x = 0 .. size_x - 1 of row (iz, iy), into row.
+     * The lattice constraints are the same along a row, so off the crossings
+     * they are one mask over the row, and only the neuron seeds on the
+     * crossings take a branch and a second draw.
      */
-    void growth_step()
+    inline static void initial_chromo_row(const cell_rng & rng, const int iz, const int iy, const int size_x, std::uint8_t * row)
+    {
+        const cell_rng::row_draws chromo_draws = rng.row(cell_rng::CHROMO, iz, iy);
+
+        for(int ix=0; ix<size_x; ++ix) {
+            row[ix] = chromo_draws(ix);
+        }
+
+        if((iz % 2) + (iy % 2) != 0) {
+            // no neuron seeds, and axons and dendrites grow along the lattice
+            std::uint8_t clear { 192 };
+            std::uint8_t set { 0 };
+
+            if(((iz + 1) % 2) * (iy % 2) == 1) {
+                clear |= 3;
+                set = 12;
+            }
+            if((iz % 2) * ((iy + 1) % 2) == 1) {
+                clear |= 12;
+                set = 3;
+            }
+
+            const std::uint8_t keep = ~clear;
+            for(int ix=0; ix<size_x; ++ix) {
+                row[ix] = (row[ix] & keep) | set;
+            }
+            return;
+        }
+
+        const cell_rng::row_draws seed_draws = rng.row(cell_rng::NEURON_SEED, iz, iy);
+        const std::uint32_t pruned = static_cast<std::uint32_t>(size_x * Rules::seed_prune_num / Rules::seed_prune_den);
+
+        for(int ix=0; ix<size_x; ++ix) {
+            if(cell::is_neuronseed(row[ix])) {
+                // dropped, or with the initial axon growth in the XY-plane
+                row[ix] = (cell_rng::below(seed_draws(ix), size_x + 1) < pruned) ? row[ix] & ~192 : row[ix] & 195;
+            }
+        }
+    }
+
+
+    /* Neurons start signaling at a random point of their cycle.
+     */
+    inline static std::uint8_t initial_activation(const cell_rng & rng, const int iz, const int iy, const int ix)
+    {
+        return cell_rng::below(rng(cell_rng::ACTIVATION, iz, iy, ix), Rules::activation_range);
+    }
+
+
+    /* What a cell puts into lane dir in the growth phase,
+     * live cells send the same growth signals every step.
+     */
+    inline static std::uint8_t growth_output(const cell_type type, const std::uint8_t chromo, const std::uint8_t gate, const int dir)
+    {
+        switch(type) {
+            case NEURON:   return (dir == gate || dir == cell::adjacent_gate(gate)) ? AXON_SIGNAL : DENDRITE_SIGNAL;
+            case AXON:     return cell::chromo_dir_choice(chromo, dir, AXON_SIGNAL, 0);
+            case DENDRITE: return cell::chromo_dir_choice(chromo, dir, DENDRITE_SIGNAL, 0);
+            default:       return 0;
+        }
+    }
+
+    /* What a BLANK cell grows into given its inputs, BLANK if nothing.
+     * Sets gate when it grows.
+     */
+    inline static cell_type grow_blank(const std::array<std::uint8_t, 6> & in, const std::uint8_t chromo, std::uint8_t & gate)
     {
         int input_sum { 0 };
-        changed = false;
-        
-        for(int iz=0; iz<GSize; ++iz) {
-            for(int iy=0; iy<GSize; ++iy) {
-                for(int ix=0; ix<GSize; ++ix) {
-                    switch(grid[iz][iy][ix].type) {
-                        case BLANK: 
-                            if(grid[iz][iy][ix].is_neuronseed()) {
-                                changed = true;
-                                grid[iz][iy][ix].type = NEURON;
-                                // inform the neighbors immediately 
-                                grid[iz][iy][ix].gate = (grid[iz][iy][ix].chromo & 63) % 6;
-                                grid[iz][iy][ix].iobuf.fill(DENDRITE_SIGNAL);
-                                grid[iz][iy][ix].iobuf_from_gate() = AXON_SIGNAL;
-                                grid[iz][iy][ix].iobuf_from_adjacent_gate() = AXON_SIGNAL;
-                                break;
-                            }
-
-                            /* The blank neighbors, which receive a neural growth signal, turn into either an axon cell or a dendrite cell.
-                             * The growth signals include information containing the cell type of the cell that is to be grown from the signal. 
-                             * To decide in which directions axonal or dendritic trails should grow, 
-                             * the grown cells consult their chromosome information which encodes the growth instructions. 
-                             * These growth instructions can have an absolute or a relative directional encoding. 
-                             * An absolute encoding masks the six neighbors (i.e. directions) of a 3D cell with six bits.
-                             * After a cell is grown, it accepts growth signals only from the direction from which it received its first signal. 
-                             * This reception direction information is stored in the gate position of each cell's state.
-                             */
-
-                            // test for no signal 
-                            input_sum = fold_plus(grid[iz][iy][ix].iobuf);
-                            if(input_sum == 0) {
-                                break;
-                            }
-
-                            // test for axon signals
-                            input_sum = fold_plus_and(grid[iz][iy][ix].iobuf, AXON_SIGNAL); 
-                            if(input_sum == AXON_SIGNAL) {
-                                changed = true;
-                                grid[iz][iy][ix].type = AXON;
-
-                                for(int i=0; i<6; ++i) {
-                                    if(grid[iz][iy][ix].iobuf[i] == AXON) {
-                                        grid[iz][iy][ix].gate = i;
-                                    }
-
-                                    grid[iz][iy][ix].iobuf[i] = grid[iz][iy][ix].chromo_dir_choice(i, AXON_SIGNAL, 0);
-                                }
-                                break;
-                            }
-
-                            if(input_sum > AXON_SIGNAL) {
-                                grid[iz][iy][ix].iobuf.fill(0);
-                                break;
-                            }
-
-                            // test for dendrite signals
-                            input_sum = fold_plus_and(grid[iz][iy][ix].iobuf, DENDRITE_SIGNAL);
-                            if(input_sum == DENDRITE_SIGNAL) {
-                                changed = true;
-                                grid[iz][iy][ix].type = DENDRITE;
-
-                                for(int i=0; i<6; ++i) {
-                                    if(grid[iz][iy][ix].iobuf[i] != 0) {
-                                        grid[iz][iy][ix].gate = cell::adjacent_gate(i);
-                                    }
-                    
-                                    grid[iz][iy][ix].iobuf[i] = grid[iz][iy][ix].chromo_dir_choice(i, DENDRITE_SIGNAL, 0);
-                                }
-
-                                break;
-                            }
-
-                            // default (more than one dendrite signal and no axon signal)
-                            grid[iz][iy][ix].iobuf.fill(0);
-                            break;
-
-                          case NEURON:
-                            grid[iz][iy][ix].iobuf.fill(DENDRITE_SIGNAL);
-                            grid[iz][iy][ix].iobuf_from_gate() = AXON_SIGNAL;
-                            grid[iz][iy][ix].iobuf_from_adjacent_gate() = AXON_SIGNAL; 
-                            break;
-
-                        case AXON:
-                            for(int i=0; i<6; ++i) {
-                                grid[iz][iy][ix].iobuf[i] = grid[iz][iy][ix].chromo_dir_choice(i, AXON_SIGNAL, 0);
-                            }
-                            break;
-
-                        case DENDRITE:
-                            for(int i=0; i<6; ++i) {
-                                grid[iz][iy][ix].iobuf[i] = grid[iz][iy][ix].chromo_dir_choice(i, DENDRITE_SIGNAL, 0);
-                            }
-                            break;
-
-                        default:
-                            std::cerr << "something else wtf" << std::endl;
-                            exit(1);
-                            break;
-                    }
+
+        if(cell::is_neuronseed(chromo)) {
+            // inform the neighbors immediately
+            gate = (chromo & 63) % 6;
+            return NEURON;
+        }
+
+        /* The blank neighbors, which receive a neural growth signal, turn into either an axon cell or a dendrite cell.
+         * The growth signals include information containing the cell type of the cell that is to be grown from the signal.
+         * To decide in which directions axonal or dendritic trails should grow,
+         * the grown cells consult their chromosome information which encodes the growth instructions.
+         * These growth instructions can have an absolute or a relative directional encoding.
+         * An absolute encoding masks the six neighbors (i.e. directions) of a 3D cell with six bits.
+         * After a cell is grown, it accepts growth signals only from the direction from which it received its first signal.
+         * This reception direction information is stored in the gate position of each cell's state.
+         */
+
+        // test for no signal
+        input_sum = fold_plus(in);
+        if(input_sum == 0) {
+            return BLANK;
+        }
+
+        // test for axon signals
+        input_sum = fold_plus_and(in, AXON_SIGNAL);
+        if(input_sum == AXON_SIGNAL) {
+            for(int d=0; d<6; ++d) {
+                if(in[d] == AXON) {
+                    gate = d;
                 }
             }
+            return AXON;
+        }
+
+        if(input_sum > AXON_SIGNAL) {
+            return BLANK;
         }
 
-        kicking(); 
+        // test for dendrite signals
+        input_sum = fold_plus_and(in, DENDRITE_SIGNAL);
+        if(input_sum == DENDRITE_SIGNAL) {
+            for(int d=0; d<6; ++d) {
+                if(in[d] != 0) {
+                    gate = cell::adjacent_gate(d);
+                }
+            }
+            return DENDRITE;
+        }
+
+        // default (more than one dendrite signal and no axon signal)
+        return BLANK;
     }
 
 
-    /* Signals are distributed from the neuron bodies via their axon tree 
-     * and collected from connection dendrites.
+private:
+    /* In a growth phase a neural network is grown in the CA-space based on an underlying chromosome.
+     * The growth phase is followed by a signaling- or processing-phase
      */
-    void signal_step()
+    bool grow_cells(worker_counters & count, const std::size_t begin, const std::size_t end)
     {
-        std::uint8_t input_sum { 0 };
-
-        for(int iz=0; iz<GSize; ++iz) {
-            for(int iy=0; iy<GSize; ++iy) {
-                for(int ix=0; ix<GSize; ++ix) {
-                    switch(grid[iz][iy][ix].type) {
-                        case BLANK: break;
-
-                        /* The neurons sum the incoming signal values and fire after a threshold is reached. 
-                         * This behavior of the neuron bodies can be modified easily to suit a given problem.
-                         * The output of the neuron bodies is passed on to its surrounding axon cells. 
-                         * These two types of cell-to-cell interaction cover all kinds of cell encounters.
-                         */
-                        case NEURON:
-                            input_sum = 1 // add default gain
-                                 + fold_plus(grid[iz][iy][ix].iobuf)
-                                 - grid[iz][iy][ix].iobuf_from_gate()
-                                 - grid[iz][iy][ix].iobuf_from_adjacent_gate();
-                            
-                            grid[iz][iy][ix].iobuf.fill(0);
-                            grid[iz][iy][ix].activation += input_sum;
-                            
-                             // Fire now.
-                            if(grid[iz][iy][ix].activation > 31) {
-                                grid[iz][iy][ix].iobuf_from_gate() = 1;
-                                grid[iz][iy][ix].iobuf_from_adjacent_gate() = 1;
-                                grid[iz][iy][ix].activation = 0;
-                            }
-                            break;
-
-                        case AXON:
-                            grid[iz][iy][ix].iobuf.fill(grid[iz][iy][ix].iobuf_from_gate());
-                            grid[iz][iy][ix].activation = (grid[iz][iy][ix].iobuf_from_gate() != 0) ? 1 : 0;
-                            break;
-
-
-                        case DENDRITE:
-                            input_sum = fold_plus(grid[iz][iy][ix].iobuf);
-                            input_sum = (input_sum > 2) ? 2 : input_sum;
-                            grid[iz][iy][ix].iobuf.fill(0);
-                            grid[iz][iy][ix].iobuf_from_gate() = input_sum;
-                            grid[iz][iy][ix].activation = (input_sum != 0) ? 1 : 0;
-                            break;
+        const lane_pointers io = lanes();
+        bool grown { false };
+
+        for(std::size_t i=begin; i<end; ++i) {
+            cell_type type = grid.type[i];
+
+            switch(type) {
+                case BLANK:
+                    type = grow_blank(iobuf_of(io, i), grid.chromo[i], grid.gate[i]);
+
+                    // signals that did not make it grow are dropped
+                    if(type == BLANK) {
+                        iobuf_fill(io, i, 0);
+                        continue;
                     }
+
+                    grown = true;
+                    grid.type[i] = type;
+                    count.grew(type);
+                    break;
+
+                case NEURON:
+                case AXON:
+                case DENDRITE:
+                    break;
+
+                default:
+                    std::cerr << "something else wtf" << std::endl;
+                    exit(1);
+                    break;
+            }
+
+            for(int d=0; d<6; ++d) {
+                io[d][i] = growth_output(type, grid.chromo[i], grid.gate[i], d);
+            }
+        }
+
+        return grown;
+    }
+
+    /* After a growth step (and its kick) every lane holds exactly what its
+     * source neighbor sends: the constant output of a live cell, 0 from a
+     * blank one or the border. Growth signals therefore only ever travel one
+     * cell, and a blank cell can only change when a neighbor has just grown.
+     * The frontier step keeps the lanes in that state by writing the outputs
+     * of new cells straight into their neighbors, instead of kicking, and
+     * only looks at the blank cells that got new input.
+     */
+    void build_frontier()
+    {
+        const lane_pointers io = lanes();
+
+        frontier.clear();
+        queued.assign(volume(), 0);
+
+        for(std::size_t i=0; i<volume(); ++i) {
+            if(grid.type[i] == BLANK && (cell::is_neuronseed(grid.chromo[i]) || iobuf_sum(io, i) != 0)) {
+                frontier.push_back(i);
+                queued[i] = 1;
+            }
+        }
+
+        frontier_valid = true;
+    }
+
+    void frontier_growth_step()
+    {
+        const lane_pointers io = lanes();
+
+        if(!frontier_valid) {
+            build_frontier();
+        }
+
+        // every cell decides on the inputs of the last step
+        grown_cells.clear();
+        for(const std::size_t i : frontier) {
+            queued[i] = 0;
+
+            if(grid.type[i] != BLANK) {
+                continue;
+            }
+
+            std::uint8_t gate = grid.gate[i];
+            const cell_type type = grow_blank(iobuf_of(io, i), grid.chromo[i], gate);
+
+            if(type != BLANK) {
+                grid.type[i] = type;
+                grid.gate[i] = gate;
+                grown_cells.push_back(i);
+                counters.worker(0).grew(type);
+            }
+        }
+
+        counters.frontier(frontier.size(), grown_cells.size());
+
+        // then the new cells send, a blank cell sent 0 before
+        frontier.clear();
+        for(const std::size_t i : grown_cells) {
+            for(int d=0; d<6; ++d) {
+                std::size_t to;
+                const std::uint8_t v = growth_output(grid.type[i], grid.chromo[i], grid.gate[i], d);
+
+                if(v == 0 || !lane_target(d, i, to)) {
+                    continue;
+                }
+
+                io[d][to] = v;
+                if(grid.type[to] == BLANK && !queued[to]) {
+                    queued[to] = 1;
+                    frontier.push_back(to);
                 }
             }
         }
-        
-        kicking(); 
+
+        changed = !grown_cells.empty();
     }
 
+    void growth_step()
+    {
+        {
+            const instrumentation::timer timer(counters, step_phase::GROWTH);
 
-public:
-    std::array<std::array<std::array<cell, GSize>, GSize>, GSize> grid;
-    
-    network() : changed(true), has_setup_signaling(false)
-    {
-        std::uniform_int_distribution<std::uint32_t> gsize_rng(0, GSize);
-
-        for(int iz=0; iz<GSize; ++iz) {
-            for(int iy=0; iy<GSize; ++iy) {
-                for(int ix=0; ix<GSize; ++ix) {
-                    // restrict to grid
-                    if(((iz + 1) % 2) * (iy % 2) == 1) {
-                        grid[iz][iy][ix].chromo = (grid[iz][iy][ix].chromo & ~3) | 12;
-                    }
+            if(grower == growth_engine::FRONTIER) {
+                frontier_growth_step();
+                return;
+            }
 
-                    if((iz % 2) * ((iy + 1) % 2) == 1) {
-                        grid[iz][iy][ix].chromo = (grid[iz][iy][ix].chromo & ~12) | 3;
-                    }
+            std::atomic<bool> grown { false };
+            frontier_valid = false;
 
-                    // Kill unwanted neuronseeds. Neuronsee only on crossings.
-                    if((iz % 2) + (iy % 2) != 0) {
-                        grid[iz][iy][ix].chromo &= ~192;
-                    }
+            for_each_slab([&](const unsigned worker, const std::size_t begin, const std::size_t end) {
+                if(grow_cells(counters.worker(worker), begin, end)) {
+                    grown = true;
+                }
+            });
 
-                    // Decrease prob of neuronseeds
-                    if(grid[iz][iy][ix].is_neuronseed()) {
-                        if(gsize_rng(rng_gen) < (GSize / 2)) {
-                            grid[iz][iy][ix].chromo &= ~192;
-                        }
+            changed = grown;
+        }
+
+        kicking();
+    }
+
+
+    void signal_step()
+    {
+        const signal_planes planes { grid.type.data(), grid.gate.data(), grid.activation.data(), lanes() };
+
+        {
+            const instrumentation::timer timer(counters, step_phase::SIGNAL);
+
+            for_each_slab([&](unsigned, const std::size_t begin, const std::size_t end) {
+                signal_cells<Rules>(kernel, planes, begin, end);
+            });
+        }
+
+        // a pass of its own, so it does not count as signaling time
+        if(instrumented) {
+            for_each_slab([&](const unsigned worker, const std::size_t begin, const std::size_t end) {
+                counters.worker(worker).signaled(planes.type, planes.activation, begin, end);
+            });
+        }
+
+        kicking();
+    }
+
+
+    /* How far one kick slides each lane, see kicking().
+     */
+    inline std::array<std::ptrdiff_t, 6> lane_strides() const
+    {
+        const std::ptrdiff_t nx = extent.x();
+        const std::ptrdiff_t nxy = nx * extent.y();
+        return {{ 1, -1, nx, -nx, nxy, -nxy }};
+    }
+
+    /* Signals plane iz as the `level`th of fused steps. The lanes are read
+     * through windows `level` kicks ahead of the grid's, which is all a kick
+     * does besides clearing the faces that came in from outside the grid,
+     * so the kicks in between never have to happen.
+     * Every lane byte in the windows belongs to one cell and one level,
+     * a plane only ever reads what the planes next to it wrote a level
+     * before, in place, and the planes may go in any order that has
+     * their neighbors one level ahead.
+     */
+    void signal_plane(const unsigned worker, const int iz, const int level)
+    {
+        const std::size_t nx = extent.x();
+        const std::size_t nxy = nx * extent.y();
+        const std::size_t i = index(iz, 0, 0);
+        const std::array<std::ptrdiff_t, 6> stride = lane_strides();
+        lane_pointers io = lanes();
+
+        for(int d=0; d<6; ++d) {
+            io[d] += level * stride[d] + static_cast<std::ptrdiff_t>(i);
+        }
+
+        if(level > 0) {
+            for(std::size_t row=0; row<nxy; row+=nx) {
+                io[0][row + nx - 1] = 0;
+                io[1][row] = 0;
+            }
+
+            std::fill_n(io[2] + nxy - nx, nx, 0);
+            std::fill_n(io[3], nx, 0);
+
+            if(iz == extent.z() - 1) {
+                std::fill_n(io[4], nxy, 0);
+            }
+            if(iz == 0) {
+                std::fill_n(io[5], nxy, 0);
+            }
+        }
+
+        const signal_planes planes { grid.type.data() + i, grid.gate.data() + i, grid.activation.data() + i, io };
+        signal_cells<Rules>(kernel, planes, 0, nxy);
+        counters.worker(worker).signaled(planes.type, planes.activation, 0, nxy);
+    }
+
+    /* Levels 0 to steps-1 of the planes [begin + level * grow_begin, end + level * grow_end),
+     * as a wavefront: level t runs t planes behind level 0,
+     * so the few planes around the front stay in the cache for all levels.
+     */
+    void signal_wavefront(const unsigned worker, const int steps, const int begin, const int grow_begin,
+                          const int end, const int grow_end)
+    {
+        const int first = std::min(begin, begin + (steps - 1) * grow_begin);
+        const int last = std::max(end, end + (steps - 1) * grow_end);
+
+        for(int front=first; front<last+steps; ++front) {
+            for(int level=0; level<steps; ++level) {
+                const int iz = front - level;
+
+                if(iz >= begin + level * grow_begin && iz < end + level * grow_end) {
+                    signal_plane(worker, iz, level);
+                }
+            }
+        }
+    }
+
+    /* `steps` signaling steps in one pass over the grid, see set_temporal_tiling.
+     *
+     * Each worker runs the levels of its own slab of planes that do not
+     * need the planes of another, a trapezoid narrowing by a plane a level
+     * at both inner ends. Then the triangles left between the slabs are
+     * filled in, each by one worker. That takes slabs of at least
+     * 2 * steps planes, with fewer planes some workers sit it out.
+     */
+    void tiled_signal_steps(const int steps)
+    {
+        const int nz = extent.z();
+        const std::array<std::ptrdiff_t, 6> stride = lane_strides();
+
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].make_room(steps * stride[d]);
+        }
+
+        {
+            const instrumentation::timer timer(counters, step_phase::SIGNAL);
+            const int slabs = std::max(1, std::min<int>(threads(), nz / (2 * steps)));
+
+            if(slabs == 1) {
+                signal_wavefront(0, steps, 0, 0, nz, 0);
+            } else {
+                const auto slab_begin = [&](const int n) { return static_cast<int>(static_cast<long>(nz) * n / slabs); };
+
+                workers->run(slabs, [&](const unsigned worker, const std::size_t begin, const std::size_t end) {
+                    for(std::size_t n=begin; n<end; ++n) {
+                        const int first = (n == 0) ? 0 : 1;
+                        const int last = (static_cast<int>(n) == slabs - 1) ? 0 : -1;
+                        signal_wavefront(worker, steps, slab_begin(n), first, slab_begin(n + 1), last);
                     }
+                });
 
-                    // restrict axon-initial-growth in neuron to XY-plane.
-                    if(grid[iz][iy][ix].is_neuronseed()) {
-                        grid[iz][iy][ix].chromo = (grid[iz][iy][ix].chromo & 192) | ((grid[iz][iy][ix].chromo & 63) % 4);
+                workers->run(slabs - 1, [&](const unsigned worker, const std::size_t begin, const std::size_t end) {
+                    for(std::size_t n=begin; n<end; ++n) {
+                        signal_wavefront(worker, steps, slab_begin(n + 1), -1, slab_begin(n + 1), 1);
                     }
-                }
+                });
             }
         }
+
+        const instrumentation::timer timer(counters, step_phase::KICK);
+        for(int d=0; d<6; ++d) {
+            grid.iobuf[d].slide(steps * stride[d]);
+        }
+        clear_faces();
+    }
+
+
+public:
+    // the numbers in the rules, for engines that run them on this network's cells
+    typedef Rules rules_type;
+
+    cell_planes<Extent> grid;
+
+    /* An extent with a size picks the grid, e.g.
+     * basic_network<dynamic_extent>(dynamic_extent(512, 512, 64, true), seed).
+     * The same extent and seed give the same network, without a seed it is random.
+     */
+    basic_network(const Extent & e, const std::uint64_t seed) :
+        extent(e),
+        network_seed(seed),
+        changed(true),
+        has_setup_signaling(false),
+        kernel(best_signal_kernel()),
+        grower(growth_engine::FRONTIER),
+        frontier_valid(false),
+        tile_steps(1),
+        grid(extent)
+    {
+        initialize();
+    }
+
+    explicit basic_network(const Extent & e = Extent()) : basic_network(e, random_seed()) { }
+
+    explicit basic_network(const std::uint64_t seed) : basic_network(Extent(), seed) { }
+
+
+    inline std::uint64_t seed() const
+    {
+        return network_seed;
+    }
+
+    /* Starts over as the network basic_network(extent, seed) would be,
+     * in the memory this one already has, on the worker threads.
+     * Threads, kernels and engines stay as they are set.
+     */
+    void reset(const std::uint64_t seed)
+    {
+        network_seed = seed;
+        initialize();
+    }
+
+    /* Starts over from a blank grid with the given chromosome,
+     * one byte per cell in index order, e.g. from a genome.
+     */
+    void set_chromo(const std::uint8_t * chromo)
+    {
+        for_each_slab([&](unsigned, const std::size_t begin, const std::size_t end) {
+            std::copy(chromo + begin, chromo + end, grid.chromo.data() + begin);
+            clear_cells(begin, end);
+        });
+
+        changed = true;
+        has_setup_signaling = false;
+        frontier_valid = false;
+    }
+
+
+    inline int size_x() const { return extent.x(); }
+    inline int size_y() const { return extent.y(); }
+    inline int size_z() const { return extent.z(); }
+
+    inline std::size_t volume() const
+    {
+        return extent.volume();
+    }
+
+    inline std::size_t index(const int iz, const int iy, const int ix) const
+    {
+        return (static_cast<std::size_t>(iz) * extent.y() + iy) * extent.x() + ix;
+    }
+
+    /* The neighbor lane dir receives from in a kick, i.e. where its signals come from.
+     * false at the border of the grid.
+     * iobuf[0..5] = east(+x), west(-x), north(+y), south(-y), top(+z), bottom(-z)
+     */
+    inline bool lane_source(const int dir, const std::size_t i, std::size_t & from) const
+    {
+        const std::size_t nx = extent.x();
+        const std::size_t nxy = nx * extent.y();
+        const std::size_t iz = i / nxy;
+        const std::size_t iy = (i / nx) % extent.y();
+        const std::size_t ix = i % nx;
+
+        switch(dir) {
+            case 0: from = i + 1;   return ix != nx - 1;
+            case 1: from = i - 1;   return ix != 0;
+            case 2: from = i + nx;  return iy != static_cast<std::size_t>(extent.y() - 1);
+            case 3: from = i - nx;  return iy != 0;
+            case 4: from = i + nxy; return iz != static_cast<std::size_t>(extent.z() - 1);
+            case 5: from = i - nxy; return iz != 0;
+        }
+
+        return false;
+    }
+
+    /* The neighbor lane dir sends to, the source of the opposite lane.
+     */
+    inline bool lane_target(const int dir, const std::size_t i, std::size_t & to) const
+    {
+        return lane_source(cell::adjacent_gate(dir), i, to);
+    }
+
+
+    /* Accessors for a single cell, for renderers and other observers
+     * that think in coordinates rather than planes.
+     */
+    inline cell_type type(const int iz, const int iy, const int ix) const
+    {
+        return grid.type[index(iz, iy, ix)];
+    }
+
+    inline std::uint8_t activation(const int iz, const int iy, const int ix) const
+    {
+        return grid.activation[index(iz, iy, ix)];
+    }
+
+    inline std::uint8_t chromo(const int iz, const int iy, const int ix) const
+    {
+        return grid.chromo[index(iz, iy, ix)];
+    }
+
+    inline std::uint8_t gate(const int iz, const int iy, const int ix) const
+    {
+        return grid.gate[index(iz, iy, ix)];
+    }
+
+    inline std::uint8_t iobuf(const int dir, const int iz, const int iy, const int ix) const
+    {
+        return grid.iobuf[dir][index(iz, iy, ix)];
+    }
+
+
+    /* Step the grid with the given number of threads (including the caller).
+     * The result is bit-identical to the serial path for any thread count.
+     */
+    void set_threads(const unsigned threads)
+    {
+        workers.reset(threads > 1 ? new worker_pool(threads) : nullptr);
+        counters.set_workers(this->threads());
+    }
+
+    inline unsigned threads() const
+    {
+        return workers ? workers->size() : 1;
+    }
+
+    /* Phase times and cell counters, all zero unless built with CODI_INSTRUMENT.
+     */
+    inline const instrumentation & stats() const
+    {
+        return counters;
+    }
+
+    inline void reset_stats()
+    {
+        counters.reset();
+    }
+
+
+    /* Pick the signaling kernel, e.g. SCALAR to check the vector kernels against.
+     * Defaults to the best one the cpu supports.
+     */
+    inline void set_signal_kernel(const signal_kernel k)
+    {
+        kernel = k;
+    }
+
+    inline signal_kernel get_signal_kernel() const
+    {
+        return kernel;
+    }
+
+
+    /* Pick how growth steps are run, e.g. FULL_SCAN to check the frontier against.
+     * Both give the same grid after every step. Defaults to FRONTIER.
+     * Setting it again also makes the frontier rescan the grid,
+     * which is needed after editing the grid by hand while it grows.
+     */
+    inline void set_growth_engine(const growth_engine g)
+    {
+        grower = g;
+        frontier_valid = false;
+    }
+
+    inline growth_engine get_growth_engine() const
+    {
+        return grower;
+    }
+
+
+    /* Lets step_ca(n) fuse up to `steps` signaling steps into one pass
+     * over the grid, which streams each plane through the cache once for
+     * all of them instead of once per step, see signal_plane. The result
+     * is the same as that of single steps. Fits best when the planes of
+     * about steps + 2 z-layers fit in the cache of a worker.
+     * Growth steps are never fused, the frontier engine already only touches
+     * the cells that change. steps <= 1 turns it off.
+     */
+    void set_temporal_tiling(const int steps)
+    {
+        tile_steps = std::max(steps, 1);
+    }
+
+    inline int temporal_tiling() const
+    {
+        return tile_steps;
+    }
+
+
+    /* true until a growth step leaves every cell as it was.
+     */
+    inline bool growing() const
+    {
+        return changed;
+    }
+
+    /* Once growth has converged, set up the signaling state now
+     * instead of lazily in the next step_ca(),
+     * e.g. to hand the network over to another signaling engine.
+     */
+    void prepare_signaling()
+    {
+        if(!changed && !has_setup_signaling) {
+            setup_signaling();
+        }
+    }
+
+
+    /* true once the signaling state (activations, iobufs) is set up.
+     */
+    inline bool signaling_ready() const
+    {
+        return has_setup_signaling;
+    }
+
+    /* For code that fills the planes itself, e.g. from a snapshot:
+     * takes over the seed, whether the grid is still growing
+     * and whether the planes already hold a signaling state.
+     */
+    void restore_state(const std::uint64_t seed, const bool growing, const bool signaling)
+    {
+        network_seed = seed;
+        changed = growing;
+        has_setup_signaling = signaling;
+        frontier_valid = false;
     }
 
 
@@ -311,6 +980,44 @@ public:
             signal_step();
         }
     }
+
+    /* `steps` steps, the same as calling step_ca() that often.
+     * Once signaling, runs them tiled if set_temporal_tiling asked for it.
+     */
+    void step_ca(unsigned long steps)
+    {
+        for(; steps > 0 && changed; --steps) {
+            growth_step();
+        }
+
+        if(steps == 0) {
+            return;
+        }
+
+        if(!has_setup_signaling) {
+            setup_signaling();
+        }
+
+        // every lane window has to have room for the slide of all fused steps
+        const int fused = std::min(tile_steps, extent.z());
+        for(; fused > 1 && steps >= static_cast<unsigned long>(fused); steps -= fused) {
+            tiled_signal_steps(fused);
+        }
+
+        for(; steps > 0; --steps) {
+            signal_step();
+        }
+    }
 };
 
-#endif
\ No newline at end of file
+
+/* A GSize cube with its size fixed at compile time, the fast specialization.
+ */
+template <int GSize, typename Rules = codi_rules>
+using network = basic_network<fixed_extent<GSize, GSize, GSize>, Rules>;
+
+/* Any size picked at run time, on the heap.
+ */
+typedef basic_network<dynamic_extent> dynamic_network;
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef PACKED_KERNEL_H
+#define PACKED_KERNEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "cell_type.hpp"
+#include "signal_kernel.hpp"
+
+
+/* Packing and unpacking between the cell bytes of a packed_network and the
+ * planes the signal kernels work on, 16 cells at a time where the cpu can.
+ *
+ * A packed cell byte has the type in bits 0-1 (0, 1, 2, 3 for BLANK,
+ * NEURON, AXON, DENDRITE) and the gate in bits 2-4; packed outputs have
+ * lane d in bits 2d, 2d+1 of the xy byte (d < 4) or bits 2(d-4), 2(d-4)+1
+ * of the z byte.
+ */
+
+inline void unpack_cells(const std::uint8_t * c, cell_type * type, std::uint8_t * gate, const std::size_t n)
+{
+    std::size_t i { 0 };
+
+#if defined(__x86_64__) || defined(__i386__)
+    for(; i + 16 <= n; i += 16) {
+        u8x16 v;
+        simd_load(v, c + i);
+
+        const u8x16 t = v & 3;
+        const u8x16 types = t + ((t >> 1) & t & 1);
+        const u8x16 gates = v >> 2;
+
+        simd_store(reinterpret_cast<std::uint8_t *>(type) + i, types);
+        simd_store(gate + i, gates);
+    }
+#endif
+
+    for(; i<n; ++i) {
+        const std::uint8_t t = c[i] & 3;
+        type[i] = static_cast<cell_type>(t + ((t >> 1) & t & 1));
+        gate[i] = c[i] >> 2;
+    }
+}
+
+/* out[i] = (in[i] >> shift) & 3
+ */
+inline void unpack_lane(const std::uint8_t * in, std::uint8_t * out, const std::size_t n, const int shift)
+{
+    std::size_t i { 0 };
+
+#if defined(__x86_64__) || defined(__i386__)
+    for(; i + 16 <= n; i += 16) {
+        u8x16 v;
+        simd_load(v, in + i);
+
+        const u8x16 lane = (v >> shift) & 3;
+        simd_store(out + i, lane);
+    }
+#endif
+
+    for(; i<n; ++i) {
+        out[i] = (in[i] >> shift) & 3;
+    }
+}
+
+inline void pack_lanes(const std::array<std::uint8_t *, 6> & io, std::uint8_t * xy, std::uint8_t * z, const std::size_t n)
+{
+    std::size_t i { 0 };
+
+#if defined(__x86_64__) || defined(__i386__)
+    for(; i + 16 <= n; i += 16) {
+        std::array<u8x16, 6> lane;
+        for(int d=0; d<6; ++d) {
+            simd_load(lane[d], io[d] + i);
+        }
+
+        const u8x16 packed_xy = lane[0] | (lane[1] << 2) | (lane[2] << 4) | (lane[3] << 6);
+        const u8x16 packed_z  = lane[4] | (lane[5] << 2);
+
+        simd_store(xy + i, packed_xy);
+        simd_store(z + i, packed_z);
+    }
+#endif
+
+    for(; i<n; ++i) {
+        xy[i] = io[0][i] | (io[1][i] << 2) | (io[2][i] << 4) | (io[3][i] << 6);
+        z[i]  = io[4][i] | (io[5][i] << 2);
+    }
+}
+
+#endif
@@ -0,0 +1,481 @@
+#ifndef PACKED_NETWORK_H
+#define PACKED_NETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "aligned_buffer.hpp"
+#include "cell.hpp"
+#include "cell_rng.hpp"
+#include "cell_type.hpp"
+#include "grid_extent.hpp"
+#include "network.hpp"
+#include "packed_kernel.hpp"
+#include "signal_kernel.hpp"
+#include "worker_pool.hpp"
+
+
+/* A network in as few bytes per cell as the rules allow, for grids that do
+ * not fit in memory as a network. Results are the same as a network's,
+ * cell for cell.
+ *
+ * Two facts make the lanes unnecessary in growth and narrow in signaling:
+ * - after a growth step every lane holds the constant growth output of its
+ *   source neighbor, so a growing cell computes its inputs from the type,
+ *   gate and chromosome of its neighbors;
+ * - signals never exceed 2 (neurons send 1, dendrites at most 2, axons and
+ *   blank cells pass on what they get), so the six outputs of a cell fit in
+ *   12 bits, and a cell reads its inputs straight from its neighbors'
+ *   outputs, which does the kick on the fly.
+ *
+ * Growth:    chromo, type and gate (one byte, double buffered) = 3 bytes
+ * Signaling: type and gate, activation, outputs (lanes 0-3 in one byte,
+ *            4-5 in another, both double buffered) = 6 bytes
+ *
+ * against the 10 bytes of the original cell (cell.hpp: six lanes, type,
+ * activation, chromo and gate), so about 3.3 times less while growing and
+ * 1.7 times less while signaling; a network takes 16, its lanes being
+ * double size. The chromosome only matters for growth and goes once
+ * signaling starts; store() rebuilds it from the seed, so it is only kept
+ * when set_chromo() gave it.
+ *
+ * Signaling unpacks a row at a time into small lane buffers and runs the
+ * signal kernels of a network on them (signal_kernel.hpp), so the packed
+ * engine gets the same vector code. Only the kernels below see the packing;
+ * store() and the accessors give the state as a network has it.
+ */
+class packed_network
+{
+private:
+    dynamic_extent extent;
+    std::uint64_t network_seed;
+    bool changed;
+    bool has_setup_signaling;
+    bool given_chromo; // by set_chromo, not the seed's
+    std::unique_ptr<worker_pool> workers;
+    signal_kernel kernel;
+
+    aligned_buffer<std::uint8_t> chromo;      // growth only, unless given
+    aligned_buffer<std::uint8_t> cells;       // type in bits 0-1, gate in bits 2-4
+    aligned_buffer<std::uint8_t> next_cells;  // growth only
+    aligned_buffer<std::uint8_t> activations; // signaling only
+    aligned_buffer<std::uint8_t> outputs_xy;  // signaling only, lane d = 0..3 in bits 2d, 2d+1
+    aligned_buffer<std::uint8_t> outputs_z;   // lane 4 in bits 0-1, lane 5 in bits 2-3
+    aligned_buffer<std::uint8_t> next_outputs_xy;
+    aligned_buffer<std::uint8_t> next_outputs_z;
+
+    typedef basic_network<dynamic_extent> rules;
+
+
+    inline static std::uint8_t pack(const cell_type type, const std::uint8_t gate)
+    {
+        return ((type == DENDRITE) ? 3 : static_cast<std::uint8_t>(type)) | (gate << 2);
+    }
+
+    // 0, 1, 2, 3 to BLANK, NEURON, AXON, DENDRITE without a branch
+    inline static cell_type type_of(const std::uint8_t c)
+    {
+        const std::uint8_t t = c & 3;
+        return static_cast<cell_type>(t + ((t >> 1) & t & 1));
+    }
+
+    inline static std::uint8_t output(const aligned_buffer<std::uint8_t> & xy, const aligned_buffer<std::uint8_t> & z,
+                                      const std::size_t i, const int d)
+    {
+        return (d < 4) ? (xy[i] >> (2 * d)) & 3 : (z[i] >> (2 * (d - 4))) & 3;
+    }
+
+    inline static std::uint8_t gate_of(const std::uint8_t c)
+    {
+        return c >> 2;
+    }
+
+
+    /* The neighbor index of lane d is i + offsets[d], valid if it is inside
+     * the grid in that direction (see network::lane_source).
+     */
+    struct neighborhood
+    {
+        std::array<std::ptrdiff_t, 6> offsets;
+        int nx, ny, nz;
+
+        explicit neighborhood(const dynamic_extent & e) :
+            nx(e.x()),
+            ny(e.y()),
+            nz(e.z())
+        {
+            const std::ptrdiff_t y = nx;
+            const std::ptrdiff_t z = static_cast<std::ptrdiff_t>(nx) * ny;
+            offsets = {{ 1, -1, y, -y, z, -z }};
+        }
+
+        inline std::array<bool, 6> inside(const int iz, const int iy, const int ix) const
+        {
+            return {{ ix != nx - 1, ix != 0, iy != ny - 1, iy != 0, iz != nz - 1, iz != 0 }};
+        }
+    };
+
+
+    template <typename Kernel>
+    void for_each_slab(Kernel kernel)
+    {
+        if(!workers) {
+            kernel(0, extent.z());
+            return;
+        }
+
+        workers->run(extent.z(), [&](unsigned, const std::size_t z_begin, const std::size_t z_end) {
+            kernel(z_begin, z_end);
+        });
+    }
+
+
+    /* network::grow_cells, with the inputs taken from the neighbors.
+     */
+    bool grow_slab(const int z_begin, const int z_end)
+    {
+        const neighborhood n(extent);
+        bool grown { false };
+
+        for(int iz=z_begin; iz<z_end; ++iz) {
+            for(int iy=0; iy<n.ny; ++iy) {
+                for(int ix=0; ix<n.nx; ++ix) {
+                    const std::size_t i = index(iz, iy, ix);
+                    const std::uint8_t c = cells[i];
+
+                    if(type_of(c) != BLANK) {
+                        next_cells[i] = c;
+                        continue;
+                    }
+
+                    const std::array<bool, 6> inside = n.inside(iz, iy, ix);
+                    std::array<std::uint8_t, 6> in;
+
+                    for(int d=0; d<6; ++d) {
+                        const std::size_t from = i + n.offsets[d];
+                        in[d] = inside[d] ? rules::growth_output(type_of(cells[from]), chromo[from], gate_of(cells[from]), d) : 0;
+                    }
+
+                    std::uint8_t gate = gate_of(c);
+                    const cell_type type = rules::grow_blank(in, chromo[i], gate);
+
+                    next_cells[i] = pack(type, gate);
+                    grown = grown || type != BLANK;
+                }
+            }
+        }
+
+        return grown;
+    }
+
+    void growth_step()
+    {
+        std::atomic<bool> grown { false };
+
+        for_each_slab([&](const int z_begin, const int z_end) {
+            if(grow_slab(z_begin, z_end)) {
+                grown = true;
+            }
+        });
+
+        std::swap(cells, next_cells);
+        changed = grown;
+    }
+
+
+    void setup_signaling()
+    {
+        const cell_rng rng(network_seed);
+
+        has_setup_signaling = true;
+
+        // the growth buffers go, the signaling state comes
+        next_cells = aligned_buffer<std::uint8_t>();
+        if(!given_chromo) {
+            chromo = aligned_buffer<std::uint8_t>();
+        }
+        activations.allocate(volume(), extent.huge_pages);
+        outputs_xy.allocate(volume(), extent.huge_pages);
+        outputs_z.allocate(volume(), extent.huge_pages);
+        next_outputs_xy.allocate(volume(), extent.huge_pages);
+        next_outputs_z.allocate(volume(), extent.huge_pages);
+        outputs_xy.fill(0);
+        outputs_z.fill(0);
+
+        for_each_slab([&](const int z_begin, const int z_end) {
+            for(int iz=z_begin; iz<z_end; ++iz) {
+                for(int iy=0; iy<extent.y(); ++iy) {
+                    for(int ix=0; ix<extent.x(); ++ix) {
+                        const std::size_t i = index(iz, iy, ix);
+                        activations[i] = (type_of(cells[i]) == NEURON) ? rules::initial_activation(rng, iz, iy, ix) : 0;
+                    }
+                }
+            }
+        });
+    }
+
+    /* Per z-plane: the lanes as a network has them after the kick, unpacked
+     * from the neighbors' outputs, then the signal kernel, then the lanes
+     * packed into the next outputs. A plane of unpacked lanes is small
+     * enough to stay in cache.
+     */
+    void signal_slab(const int z_begin, const int z_end)
+    {
+        const std::size_t nx = extent.x();
+        const std::size_t nxy = nx * extent.y();
+
+        std::vector<std::uint8_t> scratch(8 * nxy);
+        cell_type * const type = reinterpret_cast<cell_type *>(scratch.data());
+        std::uint8_t * const gate = scratch.data() + nxy;
+        std::array<std::uint8_t *, 6> io;
+        for(int d=0; d<6; ++d) {
+            io[d] = scratch.data() + (2 + d) * nxy;
+        }
+
+        for(int iz=z_begin; iz<z_end; ++iz) {
+            const std::size_t plane = index(iz, 0, 0);
+            const std::uint8_t * const c = cells.data() + plane;
+            const std::uint8_t * const xy = outputs_xy.data() + plane;
+            const std::uint8_t * const z = outputs_z.data() + plane;
+
+            unpack_cells(c, type, gate, nxy);
+
+            // east and west, then clear what crossed a row end
+            unpack_lane(xy + 1, io[0], nxy - 1, 0);
+            unpack_lane(xy, io[1] + 1, nxy - 1, 2);
+            for(std::size_t j=0; j<nxy; j+=nx) {
+                io[0][j + nx - 1] = 0;
+                io[1][j] = 0;
+            }
+
+            unpack_lane(xy + nx, io[2], nxy - nx, 4);
+            std::fill_n(io[2] + nxy - nx, nx, 0);
+
+            std::fill_n(io[3], nx, 0);
+            unpack_lane(xy, io[3] + nx, nxy - nx, 6);
+
+            if(iz != extent.z() - 1) {
+                unpack_lane(z + nxy, io[4], nxy, 0);
+            } else {
+                std::fill_n(io[4], nxy, 0);
+            }
+
+            if(iz != 0) {
+                unpack_lane(z - nxy, io[5], nxy, 2);
+            } else {
+                std::fill_n(io[5], nxy, 0);
+            }
+
+            const signal_planes planes { type, gate, activations.data() + plane, io };
+            signal_cells(kernel, planes, 0, nxy);
+
+            pack_lanes(io, next_outputs_xy.data() + plane, next_outputs_z.data() + plane, nxy);
+        }
+    }
+
+    void signal_step()
+    {
+        for_each_slab([&](const int z_begin, const int z_end) {
+            signal_slab(z_begin, z_end);
+        });
+
+        std::swap(outputs_xy, next_outputs_xy);
+        std::swap(outputs_z, next_outputs_z);
+    }
+
+
+public:
+    /* The network basic_network(e, seed) would be.
+     */
+    packed_network(const dynamic_extent & e, const std::uint64_t seed) :
+        extent(e),
+        network_seed(seed),
+        changed(true),
+        has_setup_signaling(false),
+        given_chromo(false),
+        kernel(best_signal_kernel()),
+        chromo(e.volume(), e.huge_pages),
+        cells(e.volume(), e.huge_pages),
+        next_cells(e.volume(), e.huge_pages)
+    {
+        const cell_rng rng(network_seed);
+
+        cells.fill(pack(BLANK, 0));
+        for(int iz=0; iz<extent.z(); ++iz) {
+            for(int iy=0; iy<extent.y(); ++iy) {
+                rules::initial_chromo_row(rng, iz, iy, extent.x(), chromo.data() + index(iz, iy, 0));
+            }
+        }
+    }
+
+    /* Starts over from a blank grid with the given chromosome, like network::set_chromo.
+     */
+    void set_chromo(const std::uint8_t * c)
+    {
+        if(chromo.size() != volume()) {
+            chromo.allocate(volume(), extent.huge_pages);
+        }
+        std::copy(c, c + volume(), chromo.data());
+        given_chromo = true;
+
+        next_cells.allocate(volume(), extent.huge_pages);
+        cells.fill(pack(BLANK, 0));
+        activations = aligned_buffer<std::uint8_t>();
+        outputs_xy = aligned_buffer<std::uint8_t>();
+        outputs_z = aligned_buffer<std::uint8_t>();
+        next_outputs_xy = aligned_buffer<std::uint8_t>();
+        next_outputs_z = aligned_buffer<std::uint8_t>();
+
+        changed = true;
+        has_setup_signaling = false;
+    }
+
+
+    inline int size_x() const { return extent.x(); }
+    inline int size_y() const { return extent.y(); }
+    inline int size_z() const { return extent.z(); }
+
+    inline std::size_t volume() const
+    {
+        return extent.volume();
+    }
+
+    inline std::size_t index(const int iz, const int iy, const int ix) const
+    {
+        return (static_cast<std::size_t>(iz) * extent.y() + iy) * extent.x() + ix;
+    }
+
+    inline std::uint64_t seed() const
+    {
+        return network_seed;
+    }
+
+    /* What the grid takes now.
+     */
+    inline std::size_t bytes() const
+    {
+        return chromo.size() + cells.size() + next_cells.size() + activations.size()
+             + outputs_xy.size() + outputs_z.size() + next_outputs_xy.size() + next_outputs_z.size();
+    }
+
+
+    inline cell_type type(const int iz, const int iy, const int ix) const
+    {
+        return type_of(cells[index(iz, iy, ix)]);
+    }
+
+    inline std::uint8_t gate(const int iz, const int iy, const int ix) const
+    {
+        return gate_of(cells[index(iz, iy, ix)]);
+    }
+
+    inline std::uint8_t activation(const int iz, const int iy, const int ix) const
+    {
+        return has_setup_signaling ? activations[index(iz, iy, ix)] : 0;
+    }
+
+
+    /* Unpacks into nw, a network of the same size, in the state it would have
+     * after the same steps, lanes included.
+     */
+    template <typename Network>
+    void store(Network & nw) const
+    {
+        if(nw.size_x() != size_x() || nw.size_y() != size_y() || nw.size_z() != size_z()) {
+            throw std::invalid_argument("packed_network: the network has another size");
+        }
+
+        // a signaling network only has the chromosome if it was given, the seed's comes back
+        if(chromo.size() == volume()) {
+            std::copy_n(chromo.data(), volume(), nw.grid.chromo.data());
+        } else {
+            const cell_rng rng(network_seed);
+
+            for(int iz=0; iz<size_z(); ++iz) {
+                for(int iy=0; iy<size_y(); ++iy) {
+                    rules::initial_chromo_row(rng, iz, iy, size_x(), nw.grid.chromo.data() + nw.index(iz, iy, 0));
+                }
+            }
+        }
+
+        const neighborhood n(extent);
+
+        for(int iz=0; iz<n.nz; ++iz) {
+            for(int iy=0; iy<n.ny; ++iy) {
+                for(int ix=0; ix<n.nx; ++ix) {
+                    const std::size_t i = index(iz, iy, ix);
+                    const std::array<bool, 6> inside = n.inside(iz, iy, ix);
+
+                    nw.grid.type[i] = type_of(cells[i]);
+                    nw.grid.gate[i] = gate_of(cells[i]);
+                    nw.grid.activation[i] = has_setup_signaling ? activations[i] : 0;
+
+                    for(int d=0; d<6; ++d) {
+                        const std::size_t from = i + n.offsets[d];
+
+                        if(!inside[d]) {
+                            nw.grid.iobuf[d][i] = 0;
+                        } else if(has_setup_signaling) {
+                            nw.grid.iobuf[d][i] = output(outputs_xy, outputs_z, from, d);
+                        } else {
+                            nw.grid.iobuf[d][i] = rules::growth_output(type_of(cells[from]), chromo[from], gate_of(cells[from]), d);
+                        }
+                    }
+                }
+            }
+        }
+
+        nw.restore_state(network_seed, changed, has_setup_signaling);
+    }
+
+
+    void set_threads(const unsigned threads)
+    {
+        workers.reset(threads > 1 ? new worker_pool(threads) : nullptr);
+    }
+
+    inline unsigned threads() const
+    {
+        return workers ? workers->size() : 1;
+    }
+
+    inline void set_signal_kernel(const signal_kernel k)
+    {
+        kernel = k;
+    }
+
+    inline bool growing() const
+    {
+        return changed;
+    }
+
+    /* Once growth has converged, trade the growth buffer for the signaling
+     * state now instead of in the next step_ca().
+     */
+    void prepare_signaling()
+    {
+        if(!changed && !has_setup_signaling) {
+            setup_signaling();
+        }
+    }
+
+    void step_ca()
+    {
+        if(changed) {
+            growth_step();
+        } else {
+            if(!has_setup_signaling) {
+                setup_signaling();
+            }
+
+            signal_step();
+        }
+    }
+};
+
+#endif
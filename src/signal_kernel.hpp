@@ -0,0 +1,261 @@
+#ifndef SIGNAL_KERNEL_H
+#define SIGNAL_KERNEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "cell.hpp"
+#include "cell_rules.hpp"
+#include "cell_type.hpp"
+
+
+/* The implementations of the signaling update.
+ * SCALAR is the switch in signal_cells_scalar and the reference,
+ * SSE2 and AVX2 run the same rules branch-free on 16 or 32 cells at a time.
+ * All of them take the numbers in the rules from a rule_set, see cell_rules.hpp.
+ */
+enum class signal_kernel : std::uint8_t {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+
+/* The planes a signaling kernel reads and writes, with the iobuf lanes
+ * already resolved to their current window.
+ */
+struct signal_planes
+{
+    const cell_type * type;
+    const std::uint8_t * gate;
+    std::uint8_t * activation;
+    std::array<std::uint8_t *, 6> io;
+};
+
+
+/* The fastest kernel the cpu we are running on supports.
+ */
+inline signal_kernel best_signal_kernel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2")) {
+        return signal_kernel::AVX2;
+    }
+
+    if(__builtin_cpu_supports("sse2")) {
+        return signal_kernel::SSE2;
+    }
+#endif
+
+    return signal_kernel::SCALAR;
+}
+
+
+/* Signals are distributed from the neuron bodies via their axon tree
+ * and collected from connection dendrites.
+ */
+template <typename Rules = codi_rules>
+inline void signal_cells_scalar(const signal_planes & p, const std::size_t begin, const std::size_t end)
+{
+    const std::array<std::uint8_t *, 6> & io = p.io;
+    std::uint8_t input_sum { 0 };
+
+    for(std::size_t i=begin; i<end; ++i) {
+        const std::uint8_t gate = p.gate[i];
+        const std::uint8_t adjacent = cell::adjacent_gate(gate);
+        int sum { 0 };
+
+        switch(p.type[i]) {
+            case BLANK: break;
+
+            /* The neurons sum the incoming signal values and fire after a threshold is reached.
+             * This behavior of the neuron bodies can be modified easily to suit a given problem.
+             * The output of the neuron bodies is passed on to its surrounding axon cells.
+             * These two types of cell-to-cell interaction cover all kinds of cell encounters.
+             */
+            case NEURON:
+                for(int d=0; d<6; ++d) {
+                    sum += io[d][i];
+                }
+
+                input_sum = Rules::gain // add default gain
+                     + static_cast<std::uint8_t>(sum)
+                     - io[gate][i]
+                     - io[adjacent][i];
+
+                for(int d=0; d<6; ++d) {
+                    io[d][i] = 0;
+                }
+                p.activation[i] += input_sum;
+
+                 // Fire now.
+                if(p.activation[i] > Rules::threshold) {
+                    io[gate][i] = 1;
+                    io[adjacent][i] = 1;
+                    p.activation[i] = 0;
+                }
+                break;
+
+            case AXON:
+                input_sum = io[gate][i];
+                for(int d=0; d<6; ++d) {
+                    io[d][i] = input_sum;
+                }
+                p.activation[i] = (input_sum != 0) ? 1 : 0;
+                break;
+
+
+            case DENDRITE:
+                for(int d=0; d<6; ++d) {
+                    sum += io[d][i];
+                }
+
+                input_sum = sum;
+                input_sum = (input_sum > Rules::dendrite_clamp) ? Rules::dendrite_clamp : input_sum;
+                for(int d=0; d<6; ++d) {
+                    io[d][i] = 0;
+                }
+                io[gate][i] = input_sum;
+                p.activation[i] = (input_sum != 0) ? 1 : 0;
+                break;
+        }
+    }
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+typedef std::uint8_t u8x16 __attribute__((vector_size(16)));
+typedef std::uint8_t u8x32 __attribute__((vector_size(32)));
+
+
+/* Vectors are only passed by reference here, the by-value vector ABI
+ * differs between the default and the avx2 target.
+ */
+template <typename V>
+__attribute__((always_inline)) inline void simd_load(V & v, const std::uint8_t * p)
+{
+    std::memcpy(&v, p, sizeof(V));
+}
+
+template <typename V>
+__attribute__((always_inline)) inline void simd_store(std::uint8_t * p, const V & v)
+{
+    std::memcpy(p, &v, sizeof(V));
+}
+
+
+/* The signaling rules of signal_cells_scalar without branches:
+ * every cell computes the neuron, axon and dendrite result and the type
+ * masks pick one, BLANK (or anything else) keeps its state.
+ * uint8 arithmetic wraps exactly like the scalar code.
+ * Returns the first index it did not process (end minus the remainder).
+ */
+template <typename V, typename Rules>
+__attribute__((always_inline)) inline std::size_t signal_cells_simd(const signal_planes & p, std::size_t i, const std::size_t end)
+{
+    constexpr std::size_t width = sizeof(V);
+
+    const V zero = { };
+
+    for(; i + width <= end; i += width) {
+        V type, gate, act;
+        simd_load(type, reinterpret_cast<const std::uint8_t *>(p.type) + i);
+        simd_load(gate, p.gate + i);
+        simd_load(act, p.activation + i);
+
+        std::array<V, 6> in;
+        std::array<V, 6> is_gate;
+        V sum = zero;
+        V from_gate = zero;
+        V from_adjacent = zero;
+
+#pragma GCC unroll 6
+        for(int d=0; d<6; ++d) {
+            simd_load(in[d], p.io[d] + i);
+            is_gate[d] = reinterpret_cast<V>(gate == static_cast<std::uint8_t>(d));
+            sum += in[d];
+        }
+
+#pragma GCC unroll 6
+        for(int d=0; d<6; ++d) {
+            from_gate     |= is_gate[d] & in[d];
+            from_adjacent |= is_gate[d ^ 1] & in[d];
+        }
+
+        const V is_neuron   = reinterpret_cast<V>(type == static_cast<std::uint8_t>(NEURON));
+        const V is_axon     = reinterpret_cast<V>(type == static_cast<std::uint8_t>(AXON));
+        const V is_dendrite = reinterpret_cast<V>(type == static_cast<std::uint8_t>(DENDRITE));
+        const V keep        = ~(is_neuron | is_axon | is_dendrite);
+
+        // neuron: add default gain and the non-axon inputs, fire above the threshold
+        const V neuron_act = act + Rules::gain + sum - from_gate - from_adjacent;
+        const V fire       = reinterpret_cast<V>(neuron_act > Rules::threshold);
+        const V fire_out   = fire & 1;
+
+        // dendrite: sum clamped, sent towards the gate only
+        const V dendrite_out = sum > Rules::dendrite_clamp ? zero + Rules::dendrite_clamp : sum;
+
+        const V new_act =
+              (is_neuron   & ~fire & neuron_act)
+            | (is_axon     & reinterpret_cast<V>(from_gate != 0) & 1)
+            | (is_dendrite & reinterpret_cast<V>(dendrite_out != 0) & 1)
+            | (keep        & act);
+
+        simd_store(p.activation + i, new_act);
+
+#pragma GCC unroll 6
+        for(int d=0; d<6; ++d) {
+            const V out =
+                  (is_neuron   & (is_gate[d] | is_gate[d ^ 1]) & fire_out)
+                | (is_axon     & from_gate)
+                | (is_dendrite & is_gate[d] & dendrite_out)
+                | (keep        & in[d]);
+
+            simd_store(p.io[d] + i, out);
+        }
+    }
+
+    return i;
+}
+
+
+template <typename Rules = codi_rules>
+inline std::size_t signal_cells_sse2(const signal_planes & p, const std::size_t begin, const std::size_t end)
+{
+    return signal_cells_simd<u8x16, Rules>(p, begin, end);
+}
+
+template <typename Rules = codi_rules>
+__attribute__((target("avx2")))
+inline std::size_t signal_cells_avx2(const signal_planes & p, const std::size_t begin, const std::size_t end)
+{
+    return signal_cells_simd<u8x32, Rules>(p, begin, end);
+}
+
+#endif
+
+
+/* Runs kernel k over [begin, end) with the given rules, the scalar code
+ * picks up what the vector kernels leave over.
+ */
+template <typename Rules = codi_rules>
+inline void signal_cells(const signal_kernel k, const signal_planes & p, std::size_t begin, const std::size_t end)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch(k) {
+        case signal_kernel::AVX2: begin = signal_cells_avx2<Rules>(p, begin, end); break;
+        case signal_kernel::SSE2: begin = signal_cells_sse2<Rules>(p, begin, end); break;
+        case signal_kernel::SCALAR: break;
+    }
+#else
+    (void)k;
+#endif
+
+    signal_cells_scalar<Rules>(p, begin, end);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SLICE_RENDERER_H
+#define SLICE_RENDERER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cell_color.hpp"
+#include "cell_type.hpp"
+
+
+/* The cells of the plane x = slice() of a network as an RGBA image, one
+ * pixel a cell, z to the right and y down as the window shows it.
+ *
+ * update() compares the color of each cell with the one it has painted
+ * and only repaints the cells that changed, so a frame costs a lookup
+ * per cell and a write per changed one. The colors of cell_color are
+ * painted opaque, translucent ones over the background, so the image
+ * looks the same in a window and in a file.
+ * Works on anything with size_*(), type() and activation() by coordinates.
+ */
+class slice_renderer
+{
+private:
+    int columns;
+    int rows;
+    int x;
+    bool stale;
+    std::vector<cell_color> painted;
+    std::vector<std::uint8_t> rgba;
+    std::array<std::array<std::uint8_t, 4>, cell_colors> palette;
+
+public:
+    slice_renderer(const int size_y, const int size_z, const int slice = 0) :
+        columns(size_z),
+        rows(size_y),
+        x(slice),
+        stale(true),
+        painted(static_cast<std::size_t>(size_y) * size_z, cell_color::DEFAULT),
+        rgba(4 * painted.size())
+    {
+        const std::array<std::uint8_t, 4> & background = color_rgba(cell_color::DEFAULT);
+
+        for(int c=0; c<cell_colors; ++c) {
+            const std::array<std::uint8_t, 4> & color = color_rgba(static_cast<cell_color>(c));
+            const int alpha = color[3];
+
+            for(int n=0; n<3; ++n) {
+                palette[c][n] = (color[n] * alpha + background[n] * (255 - alpha) + 127) / 255;
+            }
+            palette[c][3] = 255;
+        }
+    }
+
+    inline int slice() const
+    {
+        return x;
+    }
+
+    /* Shows another plane, repainted whole on the next update().
+     */
+    void set_slice(const int slice)
+    {
+        x = slice;
+        stale = true;
+    }
+
+    inline int width() const
+    {
+        return columns;
+    }
+
+    inline int height() const
+    {
+        return rows;
+    }
+
+    /* width() * height() RGBA pixels, row by row.
+     */
+    inline const std::uint8_t * pixels() const
+    {
+        return rgba.data();
+    }
+
+    /* Repaints what changed in nw since the last call, returns how many cells that were.
+     */
+    template <typename Network>
+    std::size_t update(const Network & nw)
+    {
+        std::size_t changed { 0 };
+
+        for(int iy=0; iy<rows; ++iy) {
+            for(int iz=0; iz<columns; ++iz) {
+                const std::size_t p = static_cast<std::size_t>(iy) * columns + iz;
+                const cell_color color = color_of(nw.type(iz, iy, x), nw.activation(iz, iy, x));
+
+                if(color != painted[p] || stale) {
+                    painted[p] = color;
+                    std::copy_n(palette[static_cast<int>(color)].data(), 4, &rgba[4 * p]);
+                    ++changed;
+                }
+            }
+        }
+
+        stale = false;
+        return changed;
+    }
+};
+
+#endif
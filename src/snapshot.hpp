@@ -0,0 +1,498 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cell_type.hpp"
+#include "network.hpp"
+
+
+/* On-disk snapshots of a network.
+ *
+ * A snapshot is a header, a directory of planes and the planes themselves,
+ * every plane starting on a 64 byte boundary:
+ *
+ *   snapshot_header
+ *   snapshot_plane[header.planes]
+ *   plane data
+ *
+ * Fields are in host byte order, byte_order tells a reader if that is its own.
+ * A RAW plane is the plane as it is in memory: a reader can look at it in the
+ * mapped file without any parsing (snapshot_view::raw_plane), and restore()
+ * copies it without decoding. An RLE plane is a sequence of runs, each a value byte
+ * followed by the run length as an LEB128 varint. A TYPE2 plane (only the
+ * type plane) packs four cells into a byte, two bits each for BLANK, NEURON,
+ * AXON and DENDRITE, lowest bits first. Compressed snapshots use whichever
+ * encoding is smallest for each plane: RLE for the mostly empty planes of a
+ * sparse grid, TYPE2 for the type plane of a dense one.
+ *
+ * chromo, type and gate are always saved. The signaling state (activation and
+ * the six iobufs) is optional, but always saved for a network that is still
+ * growing, whose iobufs carry the growth signals.
+ *
+ * No network runs on the mapped planes: restore() always copies into the
+ * planes the network owns, whose lanes slide through buffers of twice the
+ * grid (see cell_planes.hpp). Mapping only saves reading the file into a
+ * buffer first, raw planes only save the decoding; snapshots are compressed
+ * by default, they are much smaller.
+ */
+
+enum snapshot_plane_id : std::uint32_t {
+    SNAPSHOT_CHROMO     = 0,
+    SNAPSHOT_TYPE       = 1,
+    SNAPSHOT_GATE       = 2,
+    SNAPSHOT_ACTIVATION = 3,
+    SNAPSHOT_IOBUF      = 4, // iobuf d is SNAPSHOT_IOBUF + d
+    SNAPSHOT_PLANE_IDS  = 10
+};
+
+enum snapshot_encoding : std::uint32_t {
+    SNAPSHOT_RAW   = 0,
+    SNAPSHOT_RLE   = 1,
+    SNAPSHOT_TYPE2 = 2
+};
+
+struct snapshot_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::int32_t size_x;
+    std::int32_t size_y;
+    std::int32_t size_z;
+    std::uint32_t flags;
+    std::uint64_t seed;
+    std::uint32_t planes;
+    std::uint32_t reserved;
+
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t host_byte_order = 0x01020304;
+    static constexpr std::uint32_t growing = 1;
+    static constexpr std::uint32_t signaling = 2;
+};
+
+struct snapshot_plane
+{
+    std::uint32_t id;
+    std::uint32_t encoding;
+    std::uint64_t offset; // from the start of the file
+    std::uint64_t bytes;
+};
+
+static_assert(sizeof(snapshot_header) == 48, "snapshot_header must not have padding");
+static_assert(sizeof(snapshot_plane) == 24, "snapshot_plane must not have padding");
+
+
+struct snapshot_options
+{
+    bool signaling_state; // also save activation and iobufs
+    bool compress;        // RLE or TYPE2 planes where that is smaller
+
+    snapshot_options(const bool state = true, const bool rle = true) : signaling_state(state), compress(rle) { }
+};
+
+
+inline std::vector<std::uint8_t> rle_encode(const std::uint8_t * p, const std::size_t n)
+{
+    std::vector<std::uint8_t> out;
+
+    for(std::size_t i=0; i<n; ) {
+        std::size_t run { 1 };
+        while(i + run < n && p[i + run] == p[i]) {
+            ++run;
+        }
+
+        out.push_back(p[i]);
+        for(std::size_t r=run; ; r >>= 7) {
+            out.push_back((r & 127) | ((r >= 128) ? 128 : 0));
+            if(r < 128) {
+                break;
+            }
+        }
+
+        i += run;
+    }
+
+    return out;
+}
+
+/* Throws std::runtime_error unless the runs fill exactly n bytes.
+ */
+inline void rle_decode(const std::uint8_t * in, const std::size_t bytes, std::uint8_t * p, const std::size_t n)
+{
+    const std::uint8_t * const end = in + bytes;
+    std::size_t i { 0 };
+
+    while(in != end) {
+        const std::uint8_t v = *in++;
+        std::size_t run { 0 };
+
+        for(int shift=0; ; shift += 7) {
+            if(in == end || shift > 56) {
+                throw std::runtime_error("snapshot: truncated run");
+            }
+
+            run |= static_cast<std::size_t>(*in & 127) << shift;
+            if((*in++ & 128) == 0) {
+                break;
+            }
+        }
+
+        if(run > n - i) {
+            throw std::runtime_error("snapshot: runs overflow the plane");
+        }
+
+        std::memset(p + i, v, run);
+        i += run;
+    }
+
+    if(i != n) {
+        throw std::runtime_error("snapshot: runs do not fill the plane");
+    }
+}
+
+
+inline std::vector<std::uint8_t> type2_encode(const cell_type * type, const std::size_t n)
+{
+    std::vector<std::uint8_t> out((n + 3) / 4, 0);
+
+    for(std::size_t i=0; i<n; ++i) {
+        std::uint8_t code { 0 };
+
+        switch(type[i]) {
+            case BLANK:    code = 0; break;
+            case NEURON:   code = 1; break;
+            case AXON:     code = 2; break;
+            case DENDRITE: code = 3; break;
+        }
+
+        out[i / 4] |= code << (2 * (i % 4));
+    }
+
+    return out;
+}
+
+inline void type2_decode(const std::uint8_t * in, const std::size_t bytes, cell_type * type, const std::size_t n)
+{
+    static const cell_type types[4] = { BLANK, NEURON, AXON, DENDRITE };
+
+    if(bytes != (n + 3) / 4) {
+        throw std::runtime_error("snapshot: packed plane has the wrong size");
+    }
+
+    for(std::size_t i=0; i<n; ++i) {
+        type[i] = types[(in[i / 4] >> (2 * (i % 4))) & 3];
+    }
+}
+
+
+/* Writes nw to path, throws std::runtime_error if that fails.
+ */
+template <typename Network>
+void save_snapshot(const Network & nw, const std::string & path, const snapshot_options & options = snapshot_options())
+{
+    const std::size_t volume = nw.volume();
+    const bool state = options.signaling_state || nw.growing();
+
+    std::vector<const std::uint8_t *> sources {
+        nw.grid.chromo.data(),
+        reinterpret_cast<const std::uint8_t *>(nw.grid.type.data()),
+        nw.grid.gate.data()
+    };
+
+    if(state) {
+        sources.push_back(nw.grid.activation.data());
+        for(int d=0; d<6; ++d) {
+            sources.push_back(nw.grid.iobuf[d].data());
+        }
+    }
+
+    snapshot_header header;
+    std::memcpy(header.magic, "CODISNAP", 8);
+    header.version = snapshot_header::current_version;
+    header.byte_order = snapshot_header::host_byte_order;
+    header.size_x = nw.size_x();
+    header.size_y = nw.size_y();
+    header.size_z = nw.size_z();
+    header.flags = (nw.growing() ? snapshot_header::growing : 0) | (nw.signaling_ready() && state ? snapshot_header::signaling : 0);
+    header.seed = nw.seed();
+    header.planes = sources.size();
+    header.reserved = 0;
+
+    std::vector<snapshot_plane> directory;
+    std::vector<std::vector<std::uint8_t>> encoded(sources.size());
+    std::uint64_t offset = sizeof(snapshot_header) + sources.size() * sizeof(snapshot_plane);
+
+    for(std::size_t p=0; p<sources.size(); ++p) {
+        snapshot_plane plane { static_cast<std::uint32_t>(p), SNAPSHOT_RAW, 0, volume };
+
+        if(options.compress) {
+            encoded[p] = rle_encode(sources[p], volume);
+            plane.encoding = SNAPSHOT_RLE;
+
+            if(p == SNAPSHOT_TYPE) {
+                std::vector<std::uint8_t> packed = type2_encode(nw.grid.type.data(), volume);
+
+                if(packed.size() < encoded[p].size()) {
+                    encoded[p].swap(packed);
+                    plane.encoding = SNAPSHOT_TYPE2;
+                }
+            }
+
+            if(encoded[p].size() < volume) {
+                plane.bytes = encoded[p].size();
+            } else {
+                plane.encoding = SNAPSHOT_RAW;
+            }
+        }
+
+        offset = (offset + 63) / 64 * 64;
+        plane.offset = offset;
+        offset += plane.bytes;
+        directory.push_back(plane);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    const char padding[64] = { };
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(directory.data()), directory.size() * sizeof(snapshot_plane));
+
+    for(std::size_t p=0; p<sources.size(); ++p) {
+        const std::uint8_t * data = (directory[p].encoding != SNAPSHOT_RAW) ? encoded[p].data() : sources[p];
+
+        out.write(padding, directory[p].offset - out.tellp());
+        out.write(reinterpret_cast<const char *>(data), directory[p].bytes);
+    }
+
+    if(!out) {
+        throw std::runtime_error("snapshot: could not write " + path);
+    }
+}
+
+
+/* A snapshot file mapped read-only into memory.
+ * RAW planes can be read in place with raw_plane(); a network cannot run on
+ * them, restore() copies (and decodes) every plane into one of the same size.
+ */
+class snapshot_view
+{
+private:
+    const std::uint8_t * base;
+    std::size_t length;
+    const snapshot_header * header;
+    const snapshot_plane * directory;
+
+
+    void fail(const std::string & what)
+    {
+        if(base != nullptr) {
+            munmap(const_cast<std::uint8_t *>(base), length);
+        }
+
+        throw std::runtime_error("snapshot: " + what);
+    }
+
+    inline const snapshot_plane * find(const std::uint32_t id) const
+    {
+        for(std::uint32_t p=0; p<header->planes; ++p) {
+            if(directory[p].id == id) {
+                return &directory[p];
+            }
+        }
+
+        return nullptr;
+    }
+
+public:
+    explicit snapshot_view(const std::string & path) : base(nullptr), length(0), header(nullptr), directory(nullptr)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+
+        if(fd < 0) {
+            fail("could not open " + path);
+        }
+
+        if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(snapshot_header)) {
+            close(fd);
+            fail(path + " is not a snapshot");
+        }
+
+        length = st.st_size;
+        void * p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if(p == MAP_FAILED) {
+            fail("could not map " + path);
+        }
+
+        base = static_cast<const std::uint8_t *>(p);
+        header = reinterpret_cast<const snapshot_header *>(base);
+        directory = reinterpret_cast<const snapshot_plane *>(base + sizeof(snapshot_header));
+
+        if(std::memcmp(header->magic, "CODISNAP", 8) != 0) {
+            fail(path + " is not a snapshot");
+        }
+
+        if(header->byte_order != snapshot_header::host_byte_order) {
+            fail(path + " was written with another byte order");
+        }
+
+        if(header->version != snapshot_header::current_version) {
+            fail(path + " has an unknown version");
+        }
+
+        if(header->size_x <= 0 || header->size_y <= 0 || header->size_z <= 0
+           || header->planes > SNAPSHOT_PLANE_IDS
+           || sizeof(snapshot_header) + header->planes * sizeof(snapshot_plane) > length) {
+            fail(path + " has a broken header");
+        }
+
+        for(std::uint32_t p=0; p<header->planes; ++p) {
+            const snapshot_plane & d = directory[p];
+
+            if(d.id >= SNAPSHOT_PLANE_IDS || d.encoding > SNAPSHOT_TYPE2
+               || (d.encoding == SNAPSHOT_TYPE2 && d.id != SNAPSHOT_TYPE)
+               || d.offset > length || d.bytes > length - d.offset
+               || (d.encoding == SNAPSHOT_RAW && d.bytes != volume())) {
+                fail(path + " has a broken plane directory");
+            }
+        }
+
+        if(find(SNAPSHOT_CHROMO) == nullptr || find(SNAPSHOT_TYPE) == nullptr || find(SNAPSHOT_GATE) == nullptr) {
+            fail(path + " misses a plane");
+        }
+
+        // the signaling state comes whole or not at all
+        for(int d=0; d<6 && has_signaling_state(); ++d) {
+            if(find(SNAPSHOT_IOBUF + d) == nullptr) {
+                fail(path + " misses a plane");
+            }
+        }
+    }
+
+    ~snapshot_view()
+    {
+        munmap(const_cast<std::uint8_t *>(base), length);
+    }
+
+    snapshot_view(const snapshot_view &) = delete;
+    snapshot_view & operator=(const snapshot_view &) = delete;
+
+
+    inline int size_x() const { return header->size_x; }
+    inline int size_y() const { return header->size_y; }
+    inline int size_z() const { return header->size_z; }
+
+    inline std::size_t volume() const
+    {
+        return static_cast<std::size_t>(header->size_x) * header->size_y * header->size_z;
+    }
+
+    inline std::uint64_t seed() const
+    {
+        return header->seed;
+    }
+
+    inline bool growing() const
+    {
+        return (header->flags & snapshot_header::growing) != 0;
+    }
+
+    inline bool has_signaling_state() const
+    {
+        return find(SNAPSHOT_ACTIVATION) != nullptr;
+    }
+
+    /* The plane in the mapped file, nullptr if it is not there or compressed.
+     */
+    inline const std::uint8_t * raw_plane(const snapshot_plane_id id) const
+    {
+        const snapshot_plane * p = find(id);
+        return (p != nullptr && p->encoding == SNAPSHOT_RAW) ? base + p->offset : nullptr;
+    }
+
+
+    /* Loads the snapshot into nw, which must have the same size.
+     * Without a saved signaling state the network sets it up again
+     * when it starts signaling. Throws std::runtime_error if a plane is
+     * missing or holds cell types or gates that do not exist; nw is
+     * left half loaded then.
+     */
+    template <typename Network>
+    void restore(Network & nw) const
+    {
+        if(nw.size_x() != size_x() || nw.size_y() != size_y() || nw.size_z() != size_z()) {
+            throw std::runtime_error("snapshot: the network has another size");
+        }
+
+        const auto load = [&](const snapshot_plane_id id, std::uint8_t * to) {
+            const snapshot_plane * p = find(id);
+
+            if(p == nullptr) {
+                throw std::runtime_error("snapshot: a plane is missing");
+            }
+
+            switch(p->encoding) {
+                case SNAPSHOT_RAW:   std::memcpy(to, base + p->offset, volume()); break;
+                case SNAPSHOT_RLE:   rle_decode(base + p->offset, p->bytes, to, volume()); break;
+                case SNAPSHOT_TYPE2: type2_decode(base + p->offset, p->bytes, reinterpret_cast<cell_type *>(to), volume()); break;
+            }
+        };
+
+        load(SNAPSHOT_CHROMO, nw.grid.chromo.data());
+        load(SNAPSHOT_TYPE, reinterpret_cast<std::uint8_t *>(nw.grid.type.data()));
+        load(SNAPSHOT_GATE, nw.grid.gate.data());
+
+        // the kernels index lanes by gate and switch on the type
+        for(std::size_t i=0; i<volume(); ++i) {
+            const std::uint8_t type = nw.grid.type[i];
+
+            if((type != BLANK && type != NEURON && type != AXON && type != DENDRITE) || nw.grid.gate[i] > 5) {
+                throw std::runtime_error("snapshot: a cell has no valid type or gate");
+            }
+        }
+
+        const bool state = has_signaling_state();
+
+        for(int d=0; d<6; ++d) {
+            if(state) {
+                load(static_cast<snapshot_plane_id>(SNAPSHOT_IOBUF + d), nw.grid.iobuf[d].data());
+            } else {
+                nw.grid.iobuf[d].fill(0);
+            }
+        }
+
+        if(state) {
+            load(SNAPSHOT_ACTIVATION, nw.grid.activation.data());
+        } else {
+            nw.grid.activation.fill(0);
+        }
+
+        nw.restore_state(seed(), growing(), state && (header->flags & snapshot_header::signaling) != 0);
+    }
+
+    /* A new network of the snapshot's size holding it, a dynamic_network
+     * or a basic_network<dynamic_extent, Rules> with other rules.
+     */
+    template <typename Network = dynamic_network>
+    std::unique_ptr<Network> load(const bool huge_pages = false) const
+    {
+        std::unique_ptr<Network> nw { new Network(dynamic_extent(size_x(), size_y(), size_z(), huge_pages), seed()) };
+        restore(*nw);
+        return nw;
+    }
+};
+
+#endif
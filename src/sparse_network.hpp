@@ -0,0 +1,240 @@
+#ifndef SPARSE_NETWORK_H
+#define SPARSE_NETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cell.hpp"
+#include "cell_type.hpp"
+#include "lane_links.hpp"
+#include "network.hpp"
+
+
+/* Signaling engine that only visits the non-BLANK cells of a grown network.
+ *
+ * In the signaling phase BLANK cells never touch their iobuf, so a value
+ * put into lane d travels through blank space in a straight line, one cell
+ * per kick, until it reaches a live cell (or leaves the grid).
+ * Every lane of every live cell is therefore fed by exactly one other live
+ * cell, the first one found looking the way the lane comes from,
+ * with a delay of the distance between them.
+ * Those links are resolved once, and each step moves signals along them
+ * through per-link delay lines instead of shifting whole planes.
+ * Memory is at most six links per live cell plus one delay slot per cell of
+ * blank space a link crosses; lanes a cell never reads get no delay line.
+ * Slots are 32 bit and delays 16 bit, which limits the grid to fewer than
+ * 2^32 / 6 cells and 65536 cells along any side.
+ */
+template <typename Network>
+class sparse_network
+{
+private:
+    typedef typename Network::rules_type rules;
+
+    static constexpr std::uint32_t no_source = 0xffffffff;
+
+    // neighbors: the lane reads what its source put out in the step before
+    struct direct_link
+    {
+        std::uint32_t source; // output slot, cell id * 6 + lane
+        std::uint32_t target; // input slot
+    };
+
+    // across blank space, or draining what was in flight towards the border
+    struct delay_link
+    {
+        std::uint32_t source; // output slot or no_source
+        std::uint32_t target;
+        std::uint32_t ring;   // first slot of its delay line
+        std::uint16_t length; // the delay in steps
+        std::uint16_t pos;    // slot of the value read next
+    };
+
+    std::vector<std::uint32_t> cell_index;
+    std::vector<cell_type> type;
+    std::vector<std::uint8_t> gate;
+    std::vector<std::uint8_t> activation;
+
+    std::vector<std::uint8_t> input;  // 6 per cell, what the lanes read next step
+    std::vector<std::uint8_t> output; // 6 per cell
+    std::vector<direct_link> direct_links;
+    std::vector<delay_link> delay_links;
+    std::vector<std::uint8_t> delay;
+
+
+public:
+    explicit sparse_network(const Network & nw)
+    {
+        if(nw.volume() >= no_source / 6 || std::max(nw.size_x(), std::max(nw.size_y(), nw.size_z())) > 0xffff) {
+            throw std::invalid_argument("sparse_network: the grid is too large");
+        }
+
+        std::vector<std::uint32_t> id(nw.volume(), no_source);
+
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            if(nw.grid.type[i] != BLANK) {
+                id[i] = cell_index.size();
+                cell_index.push_back(i);
+                type.push_back(nw.grid.type[i]);
+                gate.push_back(nw.grid.gate[i]);
+                activation.push_back(nw.grid.activation[i]);
+            }
+        }
+
+        input.assign(cell_index.size() * 6, 0);
+        output.assign(cell_index.size() * 6, 0);
+
+        for(std::size_t c=0; c<cell_index.size(); ++c) {
+            for(int d=0; d<6; ++d) {
+                std::vector<std::uint8_t> in_flight;
+
+                const std::ptrdiff_t source = walk_lane(nw, d, cell_index[c], [&](const std::size_t i) {
+                    in_flight.push_back(nw.grid.iobuf[d][i]);
+                });
+
+                bool pending { false };
+                for(const std::uint8_t v : in_flight) {
+                    pending = pending || v != 0;
+                }
+
+                // nothing will ever arrive on a lane that only sees the border,
+                // and axons and neurons never read some of their lanes
+                if((source == -1 && !pending) || !reads_lane(type[c], gate[c], d)) {
+                    continue;
+                }
+
+                const std::uint32_t from = (source != -1) ? id[source] * 6 + d : no_source;
+                const std::uint32_t to = c * 6 + d;
+                input[to] = in_flight[0];
+
+                if(in_flight.size() == 1 && source != -1) {
+                    direct_links.push_back({ from, to });
+                    continue;
+                }
+
+                delay_links.push_back({ from, to, static_cast<std::uint32_t>(delay.size()), static_cast<std::uint16_t>(in_flight.size()), 0 });
+                delay.insert(delay.end(), in_flight.begin(), in_flight.end());
+            }
+        }
+    }
+
+
+    /* One signal_step, see network::signal_step for the rules.
+     */
+    void step()
+    {
+        std::uint8_t input_sum { 0 };
+
+        for(std::size_t c=0; c<cell_index.size(); ++c) {
+            std::array<std::uint8_t, 6> in;
+            std::uint8_t * out = &output[c * 6];
+            const std::uint8_t g = gate[c];
+            const std::uint8_t adj = cell::adjacent_gate(g);
+            int sum { 0 };
+
+            for(int d=0; d<6; ++d) {
+                in[d] = input[c * 6 + d];
+                sum += in[d];
+            }
+
+            switch(type[c]) {
+                case BLANK: break;
+
+                case NEURON:
+                    input_sum = rules::gain // add default gain
+                        + static_cast<std::uint8_t>(sum)
+                        - in[g]
+                        - in[adj];
+
+                    std::fill_n(out, 6, 0);
+                    activation[c] += input_sum;
+
+                    if(activation[c] > rules::threshold) {
+                        out[g] = 1;
+                        out[adj] = 1;
+                        activation[c] = 0;
+                    }
+                    break;
+
+                case AXON:
+                    std::fill_n(out, 6, in[g]);
+                    activation[c] = (in[g] != 0) ? 1 : 0;
+                    break;
+
+                case DENDRITE:
+                    input_sum = sum;
+                    input_sum = (input_sum > rules::dendrite_clamp) ? rules::dendrite_clamp : input_sum;
+                    std::fill_n(out, 6, 0);
+                    out[g] = input_sum;
+                    activation[c] = (input_sum != 0) ? 1 : 0;
+                    break;
+            }
+        }
+
+        // the kick: every link takes what its source just put out
+        for(const direct_link & l : direct_links) {
+            input[l.target] = output[l.source];
+        }
+
+        for(delay_link & l : delay_links) {
+            delay[l.ring + l.pos] = (l.source != no_source) ? output[l.source] : 0;
+            if(++l.pos == l.length) {
+                l.pos = 0;
+            }
+
+            input[l.target] = delay[l.ring + l.pos];
+        }
+    }
+
+
+    /* Writes the signaling state back into nw, the network this was built from.
+     * Activations and every signal a live cell will read are exact; signals
+     * nobody reads (on their way out of the grid, or into a lane its cell
+     * ignores) were dropped and come back as 0.
+     */
+    void store(Network & nw) const
+    {
+        for(int d=0; d<6; ++d) {
+            nw.grid.iobuf[d].fill(0);
+        }
+
+        for(std::size_t c=0; c<cell_index.size(); ++c) {
+            nw.grid.activation[cell_index[c]] = activation[c];
+
+            for(int d=0; d<6; ++d) {
+                nw.grid.iobuf[d][cell_index[c]] = input[c * 6 + d];
+            }
+        }
+
+        // and what is still in blank space
+        for(const delay_link & l : delay_links) {
+            const int d = l.target % 6;
+            std::size_t j { 0 };
+
+            walk_lane(nw, d, cell_index[l.target / 6], [&](const std::size_t i) {
+                if(j != 0 && j < l.length) {
+                    nw.grid.iobuf[d][i] = delay[l.ring + (l.pos + j) % l.length];
+                }
+                ++j;
+            });
+        }
+    }
+
+
+    inline std::size_t cells() const
+    {
+        return cell_index.size();
+    }
+
+    inline std::size_t delay_slots() const
+    {
+        return delay.size();
+    }
+};
+
+template <typename Network> constexpr std::uint32_t sparse_network<Network>::no_source;
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef SPIKE_GRAPH_H
+#define SPIKE_GRAPH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cell.hpp"
+#include "cell_type.hpp"
+#include "lane_links.hpp"
+#include "network.hpp"
+
+
+/* A grown network compiled into an explicit graph and simulated event by event.
+ *
+ * Once growth has converged the topology is frozen. Axon cells only ever
+ * pass on what they get from their gate, so an axon tree is a fixed set of
+ * delays: it is folded into edges from the neuron (or dendrite) feeding it
+ * to every dendrite and neuron it reaches, each with the path length in
+ * cells as its delay. Dendrites and neurons stay nodes, since they sum
+ * (and dendrites clamp) what arrives in the same step.
+ *
+ * Signals travel as events in a timing wheel. A neuron without input just
+ * counts up its default gain, so it is only visited when something arrives
+ * or when it is due to fire on its own. The cost of a step is proportional
+ * to the spikes in flight, not to the cells, with exactly the results of
+ * network::signal_step. Cells, nodes and edges are counted in 32 bits.
+ */
+template <typename Network>
+class spike_graph
+{
+private:
+    typedef typename Network::rules_type rules;
+
+    static constexpr std::uint32_t no_node = 0xffffffff;
+
+    struct edge
+    {
+        std::uint32_t target;
+        std::uint32_t delay;
+    };
+
+    // value 0 is a neuron's own firing timer, signals are never 0
+    struct event
+    {
+        std::uint32_t node;
+        std::uint8_t value;
+    };
+
+    // nodes are the neurons and dendrites
+    std::vector<std::uint32_t> cell_index;
+    std::vector<cell_type> type;
+    std::vector<std::uint8_t> activation; // neurons, as of step updated
+    std::vector<std::uint64_t> updated;   // neurons: last step visited, dendrites: last step they sent
+    std::vector<std::uint64_t> timer;     // neurons: step they fire on their own
+    std::vector<std::uint32_t> edge_begin;
+    std::vector<edge> edges;
+
+    std::vector<std::vector<event>> wheel;
+    std::uint64_t wheel_mask;
+    std::uint64_t now; // the step to run next
+
+    std::vector<std::uint8_t> input;
+    std::vector<std::uint64_t> input_step;
+    std::vector<std::uint32_t> touched;
+    std::vector<std::uint32_t> fired_cells;
+
+
+    /* Follows a signal that cell i puts into lane dir after `delay` steps
+     * through blank space and axon trees, calling f(node, delay) for every
+     * neuron or dendrite that reads it, with the total delay.
+     */
+    template <typename F>
+    static void fan_out(const Network & nw, const std::vector<std::uint32_t> & node_id,
+                        const std::size_t i, const int dir, const std::uint32_t delay, F f)
+    {
+        struct hop { std::size_t cell; int dir; std::uint32_t delay; };
+        std::vector<hop> todo { { i, dir, delay } };
+        std::size_t axons_passed { 0 };
+
+        while(!todo.empty()) {
+            const hop h = todo.back();
+            todo.pop_back();
+
+            std::uint32_t distance { 0 };
+            const std::ptrdiff_t r = trace_lane(nw, h.dir, h.cell, distance);
+
+            if(r == -1 || !reads_lane(nw.grid.type[r], nw.grid.gate[r], h.dir)) {
+                continue;
+            }
+
+            if(nw.grid.type[r] != AXON) {
+                f(node_id[r], h.delay + distance);
+                continue;
+            }
+
+            // an axon is only fed by its gate, so a tree never gets here twice
+            if(++axons_passed > nw.volume()) {
+                throw std::runtime_error("spike_graph: axons feed each other in a loop");
+            }
+
+            for(int d=0; d<6; ++d) {
+                todo.push_back({ static_cast<std::size_t>(r), d, h.delay + distance });
+            }
+        }
+    }
+
+    inline void schedule(const std::uint64_t step, const std::uint32_t node, const std::uint8_t value)
+    {
+        wheel[step & wheel_mask].push_back({ node, value });
+    }
+
+    inline void set_timer(const std::uint32_t n)
+    {
+        // the step the default gain alone takes it above the threshold
+        timer[n] = updated[n] + ((activation[n] > rules::threshold) ? 1 : (rules::threshold - activation[n]) / rules::gain + 1);
+        schedule(timer[n], n, 0);
+    }
+
+    inline void send(const std::uint32_t n, const std::uint8_t value)
+    {
+        for(std::uint32_t e=edge_begin[n]; e<edge_begin[n + 1]; ++e) {
+            schedule(now + edges[e].delay, edges[e].target, value);
+        }
+    }
+
+    inline void receive(const std::uint32_t n, const std::uint8_t value)
+    {
+        if(input_step[n] != now) {
+            input_step[n] = now;
+            input[n] = 0;
+            touched.push_back(n);
+        }
+
+        input[n] += value;
+    }
+
+public:
+    /* Compiles nw, which must be done growing. Its current signaling state,
+     * activations and whatever is in flight in the iobufs, carries over.
+     */
+    explicit spike_graph(const Network & nw) : now(0)
+    {
+        if(nw.volume() >= no_node) {
+            throw std::invalid_argument("spike_graph: the grid is too large");
+        }
+
+        std::vector<std::uint32_t> node_id(nw.volume(), no_node);
+
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            if(nw.grid.type[i] == NEURON || nw.grid.type[i] == DENDRITE) {
+                node_id[i] = cell_index.size();
+                cell_index.push_back(i);
+                type.push_back(nw.grid.type[i]);
+                activation.push_back(nw.grid.activation[i]);
+                // as if a dendrite that is active now had sent in the last step
+                updated.push_back((nw.grid.type[i] == DENDRITE && nw.grid.activation[i] == 0) ? now - 2 : now - 1);
+            }
+        }
+
+        const std::size_t nodes = cell_index.size();
+        timer.assign(nodes, 0);
+        input.assign(nodes, 0);
+        input_step.assign(nodes, now - 1);
+
+        std::uint32_t max_delay { rules::threshold + 1u };
+
+        // neurons send along their axon, dendrites towards their gate
+        edge_begin.push_back(0);
+        for(std::uint32_t n=0; n<nodes; ++n) {
+            const std::size_t i = cell_index[n];
+            const std::uint8_t g = nw.grid.gate[i];
+            const auto add_edge = [&](const std::uint32_t target, const std::uint32_t delay) {
+                edges.push_back({ target, delay });
+                max_delay = std::max(max_delay, delay);
+            };
+
+            fan_out(nw, node_id, i, g, 0, add_edge);
+            if(type[n] == NEURON) {
+                fan_out(nw, node_id, i, cell::adjacent_gate(g), 0, add_edge);
+            }
+
+            if(edges.size() >= no_node) {
+                throw std::invalid_argument("spike_graph: too many edges");
+            }
+            edge_begin.push_back(edges.size());
+        }
+
+        // what is already in the iobufs
+        std::vector<std::pair<std::uint32_t, event>> pending;
+
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            for(int d=0; d<6; ++d) {
+                const std::uint8_t v = nw.grid.iobuf[d][i];
+                const cell_type t = nw.grid.type[i];
+                const auto arrive = [&](const std::uint32_t target, const std::uint32_t delay) {
+                    pending.push_back({ delay, event { target, v } });
+                    max_delay = std::max(max_delay, delay);
+                };
+
+                if(v == 0) {
+                    continue;
+                }
+
+                // blank cells pass it on in the next kick, live ones read it now
+                if(t == BLANK) {
+                    fan_out(nw, node_id, i, d, 0, arrive);
+                } else if(reads_lane(t, nw.grid.gate[i], d)) {
+                    if(t == AXON) {
+                        for(int e=0; e<6; ++e) {
+                            fan_out(nw, node_id, i, e, 0, arrive);
+                        }
+                    } else {
+                        arrive(node_id[i], 0);
+                    }
+                }
+            }
+        }
+
+        std::size_t wheel_size { 1 };
+        while(wheel_size <= max_delay) {
+            wheel_size *= 2;
+        }
+
+        wheel.resize(wheel_size);
+        wheel_mask = wheel_size - 1;
+
+        for(const auto & p : pending) {
+            schedule(now + p.first, p.second.node, p.second.value);
+        }
+
+        for(std::uint32_t n=0; n<nodes; ++n) {
+            if(type[n] == NEURON) {
+                set_timer(n);
+            }
+        }
+    }
+
+
+    /* One signal_step.
+     */
+    void step()
+    {
+        std::vector<event> & arriving = wheel[now & wheel_mask];
+        fired_cells.clear();
+
+        for(const event & e : arriving) {
+            if(e.value != 0 || timer[e.node] == now) {
+                receive(e.node, e.value);
+            }
+        }
+
+        arriving.clear();
+
+        for(const std::uint32_t n : touched) {
+            if(type[n] == NEURON) {
+                // the default gain of the steps nothing happened, and this one
+                activation[n] += static_cast<std::uint8_t>((now - 1 - updated[n]) * rules::gain);
+                activation[n] += static_cast<std::uint8_t>(rules::gain + input[n]);
+                updated[n] = now;
+
+                if(activation[n] > rules::threshold) {
+                    activation[n] = 0;
+                    send(n, 1);
+                    fired_cells.push_back(cell_index[n]);
+                }
+
+                set_timer(n);
+            } else {
+                const std::uint8_t v = (input[n] > rules::dendrite_clamp) ? rules::dendrite_clamp : input[n];
+
+                if(v != 0) {
+                    updated[n] = now;
+                    send(n, v);
+                }
+            }
+        }
+
+        touched.clear();
+        ++now;
+    }
+
+
+    /* Cell indices of the neurons that fired in the last step.
+     */
+    inline const std::vector<std::uint32_t> & fired() const
+    {
+        return fired_cells;
+    }
+
+    /* Writes neuron and dendrite activations into nw, the network this was
+     * compiled from. Axon activity is not tracked, their activations become 0.
+     */
+    void store(Network & nw) const
+    {
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            if(nw.grid.type[i] == AXON) {
+                nw.grid.activation[i] = 0;
+            }
+        }
+
+        for(std::size_t n=0; n<cell_index.size(); ++n) {
+            if(type[n] == NEURON) {
+                nw.grid.activation[cell_index[n]] = activation[n] + static_cast<std::uint8_t>((now - 1 - updated[n]) * rules::gain);
+            } else {
+                nw.grid.activation[cell_index[n]] = (updated[n] == now - 1) ? 1 : 0;
+            }
+        }
+    }
+
+
+    inline std::size_t nodes() const
+    {
+        return cell_index.size();
+    }
+
+    inline std::size_t edge_count() const
+    {
+        return edges.size();
+    }
+};
+
+template <typename Network> constexpr std::uint32_t spike_graph<Network>::no_node;
+
+#endif
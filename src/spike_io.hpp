@@ -0,0 +1,245 @@
+#ifndef SPIKE_IO_H
+#define SPIKE_IO_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cell.hpp"
+#include "cell_type.hpp"
+#include "spike_ring.hpp"
+
+
+/* A spike for input id, to be injected before signaling step `step`.
+ */
+struct spike_input
+{
+    std::uint64_t step;
+    std::uint32_t input;
+    std::uint8_t value;
+};
+
+/* Output neuron id fired in signaling step `step`.
+ */
+struct spike_event
+{
+    std::uint64_t step;
+    std::uint32_t neuron;
+};
+
+
+/* Drives a grown network as a spiking processor.
+ *
+ * Other threads feed spike_inputs into inputs() and read spike_events from
+ * outputs() while step() runs the network; both are single producer, single
+ * consumer rings, so nothing in the step loop blocks. Input and output ids
+ * are the order in which the cells were added.
+ *
+ * An input spike adds its value to what the cell collects:
+ * a neuron's activation (at most to just above the threshold, so it fires
+ * next step), the lanes a dendrite sums or the gate lane an axon distributes
+ * (at most to the strongest signal the rules send, rules::most_signal), so
+ * the cells stay in states the rules can reach.
+ * The input ring is first in, first out: step() injects from its front
+ * while the front is due, so an input stamped for a later step holds back
+ * every input behind it; push them in step order. Inputs arriving for a
+ * step that is already over are injected at once.
+ *
+ * An output neuron fired in a step iff its activation is 0 after it,
+ * a neuron that does not fire always adds its default gain of at least 1.
+ * Events that find the output ring full are dropped and counted.
+ */
+template <typename Network>
+class spike_io
+{
+private:
+    typedef typename Network::rules_type rules;
+
+    Network & nw;
+    std::vector<std::size_t> input_cells;
+    std::vector<std::size_t> output_cells;
+    spike_ring<spike_input> input_ring;
+    spike_ring<spike_event> output_ring;
+    std::uint64_t steps;
+    std::uint64_t lost;
+
+    void check_grown() const
+    {
+        if(nw.growing()) {
+            throw std::logic_error("spike_io: the network is still growing");
+        }
+    }
+
+    void check_cell(const std::size_t cell) const
+    {
+        if(cell >= nw.volume()) {
+            throw std::invalid_argument("spike_io: no such cell");
+        }
+    }
+
+    template <typename Add>
+    void for_each_neuron(const int z0, const int y0, const int x0, const int z1, const int y1, const int x1, Add add)
+    {
+        for(int iz=std::max(z0, 0); iz<std::min(z1, nw.size_z()); ++iz) {
+            for(int iy=std::max(y0, 0); iy<std::min(y1, nw.size_y()); ++iy) {
+                for(int ix=std::max(x0, 0); ix<std::min(x1, nw.size_x()); ++ix) {
+                    if(nw.type(iz, iy, ix) == NEURON) {
+                        add(nw.index(iz, iy, ix));
+                    }
+                }
+            }
+        }
+    }
+
+    void inject(const spike_input & s)
+    {
+        if(s.input >= input_cells.size()) {
+            return;
+        }
+
+        const std::size_t i = input_cells[s.input];
+        const std::uint8_t gate = nw.grid.gate[i];
+
+        switch(nw.grid.type[i]) {
+            case BLANK: break;
+
+            case NEURON:
+                nw.grid.activation[i] = std::min(nw.grid.activation[i] + s.value, rules::threshold + 1);
+                break;
+
+            case AXON:
+                nw.grid.iobuf[gate][i] = std::min(nw.grid.iobuf[gate][i] + s.value, rules::most_signal);
+                break;
+
+            case DENDRITE: {
+                std::uint8_t & lane = nw.grid.iobuf[cell::adjacent_gate(gate)][i];
+                lane = std::min(lane + s.value, rules::most_signal);
+                break;
+            }
+        }
+    }
+
+public:
+    /* The rings hold capacity spikes each.
+     */
+    explicit spike_io(Network & network, const std::size_t capacity = 1 << 16) :
+        nw(network),
+        input_ring(capacity),
+        output_ring(capacity),
+        steps(0),
+        lost(0)
+    { }
+
+
+    /* Any grown cell, returns its input id.
+     */
+    std::uint32_t add_input(const std::size_t cell)
+    {
+        check_grown();
+        check_cell(cell);
+        input_cells.push_back(cell);
+        return input_cells.size() - 1;
+    }
+
+    /* Every neuron in [z0, z1) x [y0, y1) x [x0, x1), in index order.
+     */
+    void add_input_region(const int z0, const int y0, const int x0, const int z1, const int y1, const int x1)
+    {
+        check_grown();
+        for_each_neuron(z0, y0, x0, z1, y1, x1, [&](const std::size_t i) { input_cells.push_back(i); });
+    }
+
+    /* A neuron, returns its output id.
+     */
+    std::uint32_t add_output(const std::size_t cell)
+    {
+        check_grown();
+        check_cell(cell);
+        if(nw.grid.type[cell] != NEURON) {
+            throw std::invalid_argument("spike_io: outputs have to be neurons");
+        }
+
+        output_cells.push_back(cell);
+        return output_cells.size() - 1;
+    }
+
+    void add_output_region(const int z0, const int y0, const int x0, const int z1, const int y1, const int x1)
+    {
+        check_grown();
+        for_each_neuron(z0, y0, x0, z1, y1, x1, [&](const std::size_t i) { output_cells.push_back(i); });
+    }
+
+
+    inline std::size_t input_count() const
+    {
+        return input_cells.size();
+    }
+
+    inline std::size_t output_count() const
+    {
+        return output_cells.size();
+    }
+
+    inline std::size_t input_cell(const std::uint32_t input) const
+    {
+        return input_cells[input];
+    }
+
+    inline std::size_t output_cell(const std::uint32_t neuron) const
+    {
+        return output_cells[neuron];
+    }
+
+    inline spike_ring<spike_input> & inputs()
+    {
+        return input_ring;
+    }
+
+    inline spike_ring<spike_event> & outputs()
+    {
+        return output_ring;
+    }
+
+    /* The signaling step the next step() runs.
+     */
+    inline std::uint64_t step_count() const
+    {
+        return steps;
+    }
+
+    /* Output events the full ring had no room for.
+     */
+    inline std::uint64_t dropped() const
+    {
+        return lost;
+    }
+
+
+    /* One signaling step with the inputs due by now and the outputs it fired.
+     */
+    void step()
+    {
+        check_grown();
+        nw.prepare_signaling();
+
+        for(const spike_input * s = input_ring.front(); s && s->step <= steps; s = input_ring.front()) {
+            inject(*s);
+
+            spike_input done;
+            input_ring.pop(done);
+        }
+
+        nw.step_ca();
+
+        for(std::size_t n=0; n<output_cells.size(); ++n) {
+            if(nw.grid.activation[output_cells[n]] == 0 && !output_ring.push(spike_event { steps, static_cast<std::uint32_t>(n) })) {
+                ++lost;
+            }
+        }
+
+        ++steps;
+    }
+};
+
+#endif
@@ -0,0 +1,656 @@
+#ifndef SPIKE_RASTER_H
+#define SPIKE_RASTER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cell_type.hpp"
+#include "network.hpp"
+#include "signal_kernel.hpp"
+
+
+/* Recordings of what a signaling network does, step by step, for offline analysis.
+ *
+ * A recording holds a set of cell indices, (iz * size_y + iy) * size_x + ix,
+ * for every `every`-th signaling step:
+ *   RASTER_FIRINGS   the neurons that fired, i.e. whose activation is 0 after it
+ *   RASTER_ACTIVITY  those and the axons and dendrites that carry a signal
+ * Activity changes little from step to step, so it is stored as the cells
+ * that changed since the recorded step before, firings as they are.
+ *
+ * Either way a step starts with a varint, 2 * count + 1 if a bitmap of all
+ * cells follows (a bit each, lowest first, in 64 bit words), 2 * count if
+ * a varint gap before each of the count cells does (the first cell, then
+ * the cells in between minus one), whichever is shorter. Steps come in chunks
+ * that start from an empty set, so each one can be decoded on its own:
+ *
+ *   raster_header
+ *   raster_chunk, payload      chunk by chunk
+ *   raster_chunk[chunks]       the index, with the offsets of the payloads
+ *   raster_trailer
+ *
+ * Fields are in host byte order, byte_order tells a reader if that is its own.
+ * A recording that ended without its index, e.g. in a crash, is read
+ * by walking the chunks up to the first one that is cut off.
+ */
+
+enum raster_kind : std::uint32_t {
+    RASTER_FIRINGS  = 0,
+    RASTER_ACTIVITY = 1
+};
+
+struct raster_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::int32_t size_x;
+    std::int32_t size_y;
+    std::int32_t size_z;
+    std::uint32_t kind;
+    std::uint32_t every;
+    std::uint32_t reserved;
+    std::uint64_t reserved2;
+
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t host_byte_order = 0x01020304;
+};
+
+struct raster_chunk
+{
+    std::uint64_t first_step;
+    std::uint64_t offset; // of the payload, from the start of the file
+    std::uint64_t bytes;
+    std::uint32_t steps;
+    std::uint32_t reserved;
+};
+
+struct raster_trailer
+{
+    std::uint64_t index_offset;
+    std::uint64_t chunks;
+    char magic[8];
+};
+
+static_assert(sizeof(raster_header) == 48, "raster_header must not have padding");
+static_assert(sizeof(raster_chunk) == 32, "raster_chunk must not have padding");
+static_assert(sizeof(raster_trailer) == 24, "raster_trailer must not have padding");
+
+constexpr char raster_magic[8] = { 'C', 'O', 'D', 'I', 'R', 'A', 'S', 'T' };
+constexpr char raster_end_magic[8] = { 'R', 'A', 'S', 'T', 'I', 'N', 'D', 'X' };
+
+
+inline void put_varint(std::vector<std::uint8_t> & out, std::uint64_t v)
+{
+    for(; v >= 128; v >>= 7) {
+        out.push_back((v & 127) | 128);
+    }
+    out.push_back(v);
+}
+
+/* Throws std::runtime_error if the varint runs past end.
+ */
+inline std::uint64_t get_varint(const std::uint8_t * & in, const std::uint8_t * const end)
+{
+    std::uint64_t v { 0 };
+
+    for(int shift=0; ; shift += 7) {
+        if(in == end || shift > 63) {
+            throw std::runtime_error("spike_raster: truncated chunk");
+        }
+
+        v |= static_cast<std::uint64_t>(*in & 127) << shift;
+        if((*in++ & 128) == 0) {
+            return v;
+        }
+    }
+}
+
+
+/* Sets bit i of out iff cell i is one a recording of that kind holds,
+ * out has to be cleared and hold n bits.
+ */
+inline void raster_bits(const cell_type * type, const std::uint8_t * activation, const std::size_t n,
+                        const raster_kind kind, std::uint64_t * out)
+{
+    std::size_t i { 0 };
+
+#if defined(__x86_64__) || defined(__i386__)
+    typedef char i8x16 __attribute__((vector_size(16)));
+
+    for(; i + 64 <= n; i += 64) {
+        std::uint64_t word { 0 };
+
+        for(int part=0; part<4; ++part) {
+            u8x16 t, a;
+            simd_load(t, reinterpret_cast<const std::uint8_t *>(type) + i + 16 * part);
+            simd_load(a, activation + i + 16 * part);
+
+            const i8x16 neuron = reinterpret_cast<i8x16>(t == static_cast<std::uint8_t>(NEURON));
+            const i8x16 off = reinterpret_cast<i8x16>(a == 0);
+            const i8x16 active = (kind == RASTER_FIRINGS) ? neuron & off
+                                                          : reinterpret_cast<i8x16>(t != static_cast<std::uint8_t>(BLANK)) & (neuron ^ ~off);
+
+            word |= static_cast<std::uint64_t>(__builtin_ia32_pmovmskb128(active) & 0xffff) << (16 * part);
+        }
+
+        out[i >> 6] = word;
+    }
+#endif
+
+    for(; i<n; ++i) {
+        const bool on = activation[i] != 0;
+        const bool active = (kind == RASTER_FIRINGS) ? type[i] == NEURON && !on
+                                                     : type[i] != BLANK && (type[i] == NEURON) != on;
+
+        out[i >> 6] |= static_cast<std::uint64_t>(active) << (i & 63);
+    }
+}
+
+
+/* Records a network while it signals: call record() after every signaling step.
+ *
+ * The step loop only encodes, into chunks of chunk_steps steps;
+ * a thread of its own writes the chunks that are done. It buffers
+ * up to max_pending of them and only holds up record() beyond that,
+ * when the disk cannot keep up. Write errors come out of the next
+ * record() or finish() as std::runtime_error.
+ */
+class raster_recorder
+{
+private:
+    std::FILE * file;
+    raster_kind kind;
+    unsigned long every;
+    std::size_t chunk_steps;
+    std::size_t max_pending;
+    std::uint64_t volume;
+
+    std::uint64_t steps;
+    std::uint64_t recorded_bytes;
+    std::vector<std::uint64_t> now;  // the cells of this step, a bit each
+    std::vector<std::uint64_t> last; // of the recorded step before, for ACTIVITY
+    raster_chunk chunk;
+    std::vector<std::uint8_t> payload;
+    std::vector<std::uint32_t> neurons;
+    bool found_neurons;
+
+    // shared with the writer
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::deque<std::pair<raster_chunk, std::vector<std::uint8_t>>> queue;
+    std::vector<raster_chunk> index;
+    std::uint64_t position;
+    bool failed;
+    bool stopping;
+
+
+    void write_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for(;;) {
+            wake.wait(lock, [&] { return stopping || !queue.empty(); });
+
+            if(queue.empty()) {
+                return;
+            }
+
+            raster_chunk c = queue.front().first;
+            const std::vector<std::uint8_t> data = std::move(queue.front().second);
+            queue.pop_front();
+            lock.unlock();
+
+            c.offset = position + sizeof(raster_chunk);
+            const bool ok = std::fwrite(&c, sizeof(c), 1, file) == 1
+                         && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+            lock.lock();
+            position = c.offset + data.size();
+            index.push_back(c);
+            failed = failed || !ok;
+            drained.notify_one();
+        }
+    }
+
+    void check() const
+    {
+        if(failed) {
+            throw std::runtime_error("spike_raster: could not write the recording");
+        }
+    }
+
+    /* Hands the chunk to the writer, and starts the next one from an empty set.
+     */
+    void flush_chunk()
+    {
+        if(chunk.steps == 0) {
+            return;
+        }
+
+        chunk.bytes = payload.size();
+        recorded_bytes += sizeof(raster_chunk) + payload.size();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            drained.wait(lock, [&] { return queue.size() < max_pending || failed; });
+            check();
+            queue.emplace_back(chunk, std::move(payload));
+        }
+        wake.notify_one();
+
+        payload.clear();
+        chunk.steps = 0;
+        std::fill(last.begin(), last.end(), 0);
+    }
+
+    /* Appends the step in `now` to the chunk.
+     */
+    void encode_step()
+    {
+        if(chunk.steps == 0) {
+            chunk.first_step = steps;
+        }
+
+        // now the change since the last step, last the cells of this one
+        if(kind == RASTER_ACTIVITY) {
+            for(std::size_t w=0; w<now.size(); ++w) {
+                last[w] ^= now[w];
+            }
+            now.swap(last);
+        }
+
+        std::uint64_t cells { 0 };
+        for(const std::uint64_t word : now) {
+            cells += __builtin_popcountll(word);
+        }
+
+        // a gap takes at least a byte
+        if(cells >= 8 * now.size()) {
+            const std::uint8_t * bitmap = reinterpret_cast<const std::uint8_t *>(now.data());
+
+            put_varint(payload, 2 * cells + 1);
+            payload.insert(payload.end(), bitmap, bitmap + 8 * now.size());
+        } else {
+            std::uint64_t next { 0 };
+
+            put_varint(payload, 2 * cells);
+            for(std::size_t w=0; w<now.size(); ++w) {
+                for(std::uint64_t bits = now[w]; bits != 0; bits &= bits - 1) {
+                    const std::uint64_t cell = 64 * w + __builtin_ctzll(bits);
+                    put_varint(payload, cell - next);
+                    next = cell + 1;
+                }
+            }
+        }
+
+        if(++chunk.steps == chunk_steps) {
+            flush_chunk();
+        }
+    }
+
+public:
+    /* Records a network of size_x * size_y * size_z cells into path,
+     * every `every` signaling steps, chunk_steps recorded steps to a chunk.
+     */
+    raster_recorder(const std::string & path, const int size_x, const int size_y, const int size_z,
+                    const raster_kind what, const unsigned long every_steps = 1,
+                    const std::size_t steps_per_chunk = 1024, const std::size_t pending_chunks = 64) :
+        file(nullptr),
+        kind(what),
+        every(every_steps),
+        chunk_steps(steps_per_chunk),
+        max_pending(pending_chunks),
+        volume(static_cast<std::uint64_t>(size_x) * size_y * size_z),
+        steps(0),
+        recorded_bytes(sizeof(raster_header)),
+        now((volume + 63) / 64, 0),
+        last(now.size(), 0),
+        found_neurons(false),
+        position(sizeof(raster_header)),
+        failed(false),
+        stopping(false)
+    {
+        if(every == 0 || chunk_steps == 0 || max_pending == 0 || volume > 0xffffffffull) {
+            throw std::invalid_argument("spike_raster: nothing to record");
+        }
+
+        file = std::fopen(path.c_str(), "wb");
+        if(!file) {
+            throw std::runtime_error("spike_raster: could not write " + path);
+        }
+
+        raster_header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, raster_magic, sizeof(h.magic));
+        h.version = raster_header::current_version;
+        h.byte_order = raster_header::host_byte_order;
+        h.size_x = size_x;
+        h.size_y = size_y;
+        h.size_z = size_z;
+        h.kind = kind;
+        h.every = every;
+
+        if(std::fwrite(&h, sizeof(h), 1, file) != 1) {
+            std::fclose(file);
+            throw std::runtime_error("spike_raster: could not write " + path);
+        }
+
+        std::memset(&chunk, 0, sizeof(chunk));
+        writer = std::thread(&raster_recorder::write_loop, this);
+    }
+
+    ~raster_recorder()
+    {
+        try {
+            finish();
+        } catch(const std::exception &) {
+        }
+    }
+
+    raster_recorder(const raster_recorder &) = delete;
+    raster_recorder & operator=(const raster_recorder &) = delete;
+
+
+    /* Signaling steps seen so far.
+     */
+    inline std::uint64_t step_count() const
+    {
+        return steps;
+    }
+
+    /* Bytes of the file so far, queued ones included.
+     */
+    inline std::uint64_t bytes() const
+    {
+        return recorded_bytes;
+    }
+
+    template <typename Network>
+    void record(const Network & nw)
+    {
+        if(++steps % every != 0) {
+            return;
+        }
+
+        check();
+        std::fill(now.begin(), now.end(), 0);
+
+        std::uint64_t i { 0 };
+        for(int iz=0; iz<nw.size_z(); ++iz) {
+            for(int iy=0; iy<nw.size_y(); ++iy) {
+                for(int ix=0; ix<nw.size_x(); ++ix, ++i) {
+                    const cell_type t = nw.type(iz, iy, ix);
+                    const bool on = nw.activation(iz, iy, ix) != 0;
+                    const bool active = (kind == RASTER_FIRINGS) ? t == NEURON && !on
+                                                                 : t != BLANK && (t == NEURON) != on;
+
+                    now[i >> 6] |= static_cast<std::uint64_t>(active) << (i & 63);
+                }
+            }
+        }
+
+        encode_step();
+    }
+
+    /* The same, straight from the planes of the grid. Types do not change
+     * while signaling, so firings only look at the neurons found the first time.
+     */
+    template <typename Extent, typename Rules>
+    void record(const basic_network<Extent, Rules> & nw)
+    {
+        if(++steps % every != 0) {
+            return;
+        }
+
+        check();
+        std::fill(now.begin(), now.end(), 0);
+
+        if(kind == RASTER_ACTIVITY) {
+            raster_bits(nw.grid.type.data(), nw.grid.activation.data(), nw.volume(), kind, now.data());
+        } else {
+            if(!found_neurons) {
+                for(std::size_t i=0; i<nw.volume(); ++i) {
+                    if(nw.grid.type[i] == NEURON) {
+                        neurons.push_back(i);
+                    }
+                }
+                found_neurons = true;
+            }
+
+            const std::uint8_t * activation = nw.grid.activation.data();
+            for(const std::uint32_t i : neurons) {
+                now[i >> 6] |= static_cast<std::uint64_t>(activation[i] == 0) << (i & 63);
+            }
+        }
+
+        encode_step();
+    }
+
+    /* Writes what is left and the index, and closes the file.
+     * Throws std::runtime_error if any of it could not be written.
+     */
+    void finish()
+    {
+        if(!file) {
+            return;
+        }
+
+        flush_chunk();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+
+        raster_trailer t;
+        std::memset(&t, 0, sizeof(t));
+        t.index_offset = position;
+        t.chunks = index.size();
+        std::memcpy(t.magic, raster_end_magic, sizeof(t.magic));
+
+        const bool ok = !failed
+                     && std::fwrite(index.data(), sizeof(raster_chunk), index.size(), file) == index.size()
+                     && std::fwrite(&t, sizeof(t), 1, file) == 1;
+        const bool closed = std::fclose(file) == 0;
+
+        file = nullptr;
+        recorded_bytes += index.size() * sizeof(raster_chunk) + sizeof(raster_trailer);
+
+        if(!ok || !closed) {
+            throw std::runtime_error("spike_raster: could not write the recording");
+        }
+    }
+};
+
+
+/* Reads a recording back, any range of steps without decoding
+ * more than the chunks it falls into.
+ */
+class raster_reader
+{
+private:
+    std::FILE * file;
+    raster_header h;
+    std::vector<raster_chunk> index;
+
+    bool read_at(const std::uint64_t offset, void * data, const std::size_t n)
+    {
+        return fseeko(file, offset, SEEK_SET) == 0 && std::fread(data, 1, n, file) == n;
+    }
+
+    /* The index of a recording without one, from the chunk headers.
+     */
+    void walk_chunks(const std::uint64_t file_bytes)
+    {
+        raster_chunk c;
+
+        for(std::uint64_t offset = sizeof(raster_header);
+            offset + sizeof(c) <= file_bytes && read_at(offset, &c, sizeof(c)); offset = c.offset + c.bytes) {
+            if(c.offset != offset + sizeof(c) || c.bytes > file_bytes - c.offset) {
+                break;
+            }
+            index.push_back(c);
+        }
+    }
+
+public:
+    explicit raster_reader(const std::string & path) :
+        file(std::fopen(path.c_str(), "rb"))
+    {
+        if(!file) {
+            throw std::runtime_error("spike_raster: could not read " + path);
+        }
+
+        if(!read_at(0, &h, sizeof(h)) || std::memcmp(h.magic, raster_magic, sizeof(h.magic)) != 0) {
+            std::fclose(file);
+            throw std::runtime_error("spike_raster: not a recording: " + path);
+        }
+        if(h.version != raster_header::current_version || h.byte_order != raster_header::host_byte_order) {
+            std::fclose(file);
+            throw std::runtime_error("spike_raster: unsupported version or byte order: " + path);
+        }
+
+        fseeko(file, 0, SEEK_END);
+        const std::uint64_t file_bytes = ftello(file);
+
+        raster_trailer t;
+        if(file_bytes >= sizeof(h) + sizeof(t) && read_at(file_bytes - sizeof(t), &t, sizeof(t))
+           && std::memcmp(t.magic, raster_end_magic, sizeof(t.magic)) == 0
+           && t.index_offset + t.chunks * sizeof(raster_chunk) + sizeof(t) == file_bytes) {
+            index.resize(t.chunks);
+            if(read_at(t.index_offset, index.data(), index.size() * sizeof(raster_chunk))) {
+                return;
+            }
+            index.clear();
+        }
+
+        walk_chunks(file_bytes);
+    }
+
+    ~raster_reader()
+    {
+        std::fclose(file);
+    }
+
+    raster_reader(const raster_reader &) = delete;
+    raster_reader & operator=(const raster_reader &) = delete;
+
+
+    inline raster_kind kind() const
+    {
+        return static_cast<raster_kind>(h.kind);
+    }
+
+    inline int size_x() const { return h.size_x; }
+    inline int size_y() const { return h.size_y; }
+    inline int size_z() const { return h.size_z; }
+
+    inline unsigned long every() const
+    {
+        return h.every;
+    }
+
+    inline const std::vector<raster_chunk> & chunks() const
+    {
+        return index;
+    }
+
+    /* Calls f(step, cells) for each recorded step with begin <= step < end,
+     * cells being the sorted cell indices of that step.
+     * Throws std::runtime_error for a chunk it cannot decode.
+     */
+    template <typename F>
+    void read(const std::uint64_t begin, const std::uint64_t end, F f)
+    {
+        const std::size_t volume = static_cast<std::size_t>(h.size_x) * h.size_y * h.size_z;
+        std::vector<std::uint8_t> data;
+        std::vector<std::uint8_t> set;
+        std::vector<std::uint32_t> cells;
+
+        for(const raster_chunk & c : index) {
+            const std::uint64_t chunk_end = c.first_step + c.steps * static_cast<std::uint64_t>(h.every);
+            if(chunk_end <= begin || c.first_step >= end) {
+                continue;
+            }
+
+            data.resize(c.bytes);
+            if(!read_at(c.offset, data.data(), data.size())) {
+                throw std::runtime_error("spike_raster: truncated chunk");
+            }
+
+            const std::uint8_t * in = data.data();
+            const std::uint8_t * const in_end = in + data.size();
+            set.assign((kind() == RASTER_ACTIVITY) ? volume : 0, 0);
+
+            for(std::uint64_t s=0, step=c.first_step; s<c.steps && step<end; ++s, step += h.every) {
+                const std::uint64_t head = get_varint(in, in_end);
+                std::uint64_t next { 0 };
+
+                cells.clear();
+                if(head & 1) {
+                    const std::size_t bitmap_bytes = 8 * ((volume + 63) / 64);
+                    if(static_cast<std::size_t>(in_end - in) < bitmap_bytes) {
+                        throw std::runtime_error("spike_raster: truncated chunk");
+                    }
+
+                    for(std::size_t w=0; w<bitmap_bytes/8; ++w, in += 8) {
+                        std::uint64_t bits;
+                        std::memcpy(&bits, in, 8);
+
+                        for(; bits != 0; bits &= bits - 1) {
+                            const std::uint64_t cell = 64 * w + __builtin_ctzll(bits);
+                            if(cell >= volume) {
+                                throw std::runtime_error("spike_raster: cell out of the grid");
+                            }
+
+                            cells.push_back(cell);
+                        }
+                    }
+                } else {
+                    for(std::uint64_t k=0; k<head/2; ++k) {
+                        const std::uint64_t cell = next + get_varint(in, in_end);
+                        if(cell >= volume) {
+                            throw std::runtime_error("spike_raster: cell out of the grid");
+                        }
+
+                        cells.push_back(cell);
+                        next = cell + 1;
+                    }
+                }
+
+                if(kind() == RASTER_ACTIVITY) {
+                    for(const std::uint32_t cell : cells) {
+                        set[cell] ^= 1;
+                    }
+
+                    cells.clear();
+                    for(std::size_t i=0; i<volume && step>=begin; ++i) {
+                        if(set[i]) {
+                            cells.push_back(i);
+                        }
+                    }
+                }
+
+                if(step >= begin) {
+                    f(step, static_cast<const std::vector<std::uint32_t> &>(cells));
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SPIKE_RING_H
+#define SPIKE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+
+/* A bounded lock-free queue between exactly one producer thread
+ * and one consumer thread. Neither side ever waits: push fails when
+ * the ring is full, pop when it is empty.
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class spike_ring
+{
+private:
+    std::vector<T> slots;
+    std::size_t mask;
+
+    // written by the consumer, read by the producer
+    alignas(64) std::atomic<std::size_t> head;
+    // written by the producer, read by the consumer
+    alignas(64) std::atomic<std::size_t> tail;
+
+public:
+    explicit spike_ring(const std::size_t capacity) :
+        head(0),
+        tail(0)
+    {
+        if(capacity == 0) {
+            throw std::invalid_argument("spike_ring: capacity 0");
+        }
+
+        std::size_t size { 1 };
+        while(size < capacity) {
+            size <<= 1;
+        }
+
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    spike_ring(const spike_ring &) = delete;
+    spike_ring & operator=(const spike_ring &) = delete;
+
+    inline std::size_t capacity() const
+    {
+        return slots.size();
+    }
+
+    /* Producer side.
+     */
+    inline bool push(const T & v)
+    {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+
+        if(t - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+
+        slots[t & mask] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Consumer side: the oldest element without removing it, nullptr if empty.
+     */
+    inline const T * front() const
+    {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+
+        if(h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        return &slots[h & mask];
+    }
+
+    /* Consumer side.
+     */
+    inline bool pop(T & v)
+    {
+        const T * f = front();
+
+        if(!f) {
+            return false;
+        }
+
+        v = *f;
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Approximate unless called from one of the two threads while the other is idle.
+     */
+    inline std::size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+#endif
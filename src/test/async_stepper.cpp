@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "async_stepper.hpp"
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+const dynamic_extent extent(21, 18, 16);
+
+/* frame holds the planes it has of nw as they are.
+ */
+bool frame_of(const network_frame & frame, const dynamic_network & nw)
+{
+    if(frame.size_x != nw.size_x() || frame.size_y != nw.size_y() || frame.size_z != nw.size_z() || frame.growing != nw.growing()) {
+        return false;
+    }
+
+    for(int iz=0; iz<nw.size_z(); ++iz) {
+        for(int iy=0; iy<nw.size_y(); ++iy) {
+            for(int ix=frame.x_begin; ix<frame.x_end; ++ix) {
+                if(frame.type(iz, iy, ix) != nw.type(iz, iy, ix) || frame.activation(iz, iy, ix) != nw.activation(iz, iy, ix)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename F>
+bool throws(F f)
+{
+    try {
+        f();
+    } catch(const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+const test_case stepper("async_stepper", [] {
+    const std::uint64_t limit { 140 };
+
+    dynamic_network nw(extent, 12);
+    async_stepper<dynamic_network> s(nw);
+    async_stepper<dynamic_network>::observer & all = s.observe(0, extent.x());
+    async_stepper<dynamic_network>::observer & some = s.observe(0, 1, 7);
+
+    // planes outside the network are refused, so the stepping thread never reads them
+    check(throws([&] { s.observe(3, extent.x() + 1); }), "async_stepper: observe() past the network");
+    check(throws([&] { s.observe(0, 1, 0); }), "async_stepper: observe() every 0 steps");
+    check(throws([&] { some.set_planes(-1, 2); }), "async_stepper: set_planes() before the network");
+    check(throws([&] { some.set_planes(4, extent.x() + 1); }), "async_stepper: set_planes() past the network");
+    check(throws([&] { some.set_planes(5, 5); }), "async_stepper: set_planes() of no planes");
+    some.set_planes(4, 9);
+
+    // copies taken while it steps, checked against single steps afterwards
+    std::map<std::uint64_t, network_frame> taken;
+    s.start(limit);
+    while(s.steps_done() < limit || taken.empty() || taken.rbegin()->first != limit) {
+        const network_frame * frame = all.latest();
+        if(frame && taken.find(frame->step) == taken.end()) {
+            taken[frame->step] = *frame;
+        }
+        std::this_thread::yield();
+    }
+    s.stop();
+
+    check(s.steps_done() == limit, "async_stepper: steps done");
+    check(all.latest()->step == limit, "async_stepper: last copy");
+    check(some.latest()->step == limit && some.latest()->x_begin == 4 && some.latest()->x_end == 9, "async_stepper: other planes");
+
+    dynamic_network reference(extent, 12);
+    bool same { true };
+    for(std::uint64_t step=0; step<=limit; ++step) {
+        const auto at = taken.find(step);
+        if(at != taken.end()) {
+            same = same && frame_of(at->second, reference);
+        }
+        if(step == limit) {
+            same = same && frame_of(*some.latest(), reference) && frame_of(*all.latest(), nw);
+        } else {
+            reference.step_ca();
+        }
+    }
+    check(same, "async_stepper: copies of " + std::to_string(taken.size()) + " steps");
+});
+
+}
@@ -0,0 +1,84 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batch_network.hpp"
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Every member of a batch, stored back, is the network its seed gives on
+ * its own: once grown, and after signaling. The batch grows until the last
+ * member converges, standalone networks signal as soon as they do, so they
+ * are compared after the same number of signaling steps.
+ */
+template <int Width, typename Rules>
+void check_members(const signal_kernel k, const std::size_t members, const std::string & what)
+{
+    typedef basic_network<dynamic_extent, Rules> rules_network;
+    const dynamic_extent e(19, 14, 11);
+
+    std::vector<std::uint64_t> seeds;
+    for(std::size_t n=0; n<members; ++n) {
+        seeds.push_back(100 + n);
+    }
+
+    batch_network<Width, Rules> batch(e, seeds);
+    batch.set_signal_kernel(k);
+    grow(batch);
+
+    std::vector<std::unique_ptr<rules_network>> alone;
+    for(std::size_t n=0; n<members; ++n) {
+        alone.emplace_back(new rules_network(e, seeds[n]));
+        alone[n]->set_signal_kernel(signal_kernel::SCALAR);
+
+        unsigned long grown_in { 0 };
+        for(; alone[n]->growing(); ++grown_in) {
+            alone[n]->step_ca();
+        }
+        check(batch.growth_steps(n) == grown_in, what + ": growth steps of member " + std::to_string(n));
+    }
+
+    rules_network stored(e, 0);
+    for(std::size_t n=0; n<members; ++n) {
+        batch.store(n, stored);
+        check_planes(*alone[n], stored, what + " grown, member " + std::to_string(n));
+    }
+
+    batch.prepare_signaling();
+    steps(batch, 45);
+    for(std::size_t n=0; n<members; ++n) {
+        alone[n]->prepare_signaling();
+        steps(*alone[n], 45);
+
+        batch.store(n, stored);
+        check_planes(*alone[n], stored, what + " signaling, member " + std::to_string(n));
+    }
+}
+
+struct members_equal_networks
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        const std::string name = std::string("batch_network ") + Rules::name();
+
+        // the vector growth and signal kernels, and the scalar rules alone
+        check_members<32, Rules>(best_signal_kernel(), 32, name);
+        check_members<32, Rules>(signal_kernel::SCALAR, 32, name + " scalar");
+        // members left empty, and a width that is not a vector
+        check_members<32, Rules>(best_signal_kernel(), 5, name + " 5 of 32");
+        check_members<7, Rules>(best_signal_kernel(), 7, name + " width 7");
+    }
+};
+
+const test_case batch("batch_network", [] {
+    members_equal_networks f;
+    for_each_rules(f);
+});
+
+}
@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <string>
+
+#include "cycle_detector.hpp"
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Skipping the whole cycles left leaves the network where running every
+ * step does, and the cycle found is one: the state after onset() comes back
+ * period() steps later.
+ */
+struct fast_forward_equals_steps
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+        // small enough to cycle within a thousand steps with any rules
+        const dynamic_extent e(6, 6, 6);
+        const unsigned long n { 20000 };
+
+        rules_network reference(e, 21);
+        grown(reference);
+        steps(reference, n);
+
+        for(const unsigned long every : { 1, 16 }) {
+            const std::string name = std::string("cycle_detector ") + Rules::name() + " every " + std::to_string(every);
+
+            rules_network nw(e, 21);
+            grow(nw);
+            cycle_detector cycles(every);
+            unsigned long observed { 0 };
+            const signal_outcome outcome = signal_with_cycles(nw, n, cycles, cycle_action::FAST_FORWARD,
+                                                              [&](const rules_network &) { ++observed; });
+
+            check(cycles.found() && outcome.simulated < n, name + ": no cycle found");
+            check(outcome.steps == n && observed == outcome.simulated, name + ": steps");
+            check_planes(reference, nw, name + ", fast forward");
+
+            // onset() is in the cycle
+            rules_network again(e, 21);
+            grown(again);
+            steps(again, cycles.onset());
+            const std::uint64_t at_onset = cycle_detector::hash(again);
+            steps(again, cycles.period());
+            check(cycle_detector::hash(again) == at_onset, name + ": period");
+
+            // STOP is where FAST_FORWARD finds it, DETECT runs it all
+            rules_network stopped(e, 21), detected(e, 21);
+            grow(stopped);
+            grow(detected);
+            cycle_detector stop_cycles(every), detect_cycles(every);
+            const signal_outcome stop = signal_with_cycles(stopped, n, stop_cycles, cycle_action::STOP);
+            const signal_outcome detect = signal_with_cycles(detected, n, detect_cycles, cycle_action::DETECT);
+
+            check(stop.steps == stop.simulated && stop.steps == stop_cycles.step_count()
+                  && stop_cycles.onset() == cycles.onset() && stop_cycles.period() == cycles.period(), name + ": stop");
+            check(detect.steps == n && detect.simulated == n, name + ": detect");
+            check_planes(reference, detected, name + ", detect");
+        }
+    }
+};
+
+const test_case cycles("cycle_detector", [] {
+    fast_forward_equals_steps f;
+    for_each_rules(f);
+});
+
+}
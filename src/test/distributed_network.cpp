@@ -0,0 +1,99 @@
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "distributed_network.hpp"
+#include "halo_transport.hpp"
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* The ranks as threads of this process, each on its slab; rank 0 gathers
+ * the grid, which is the one network of the whole extent.
+ */
+template <typename Transport>
+void check_distributed(const std::string & name, const int ranks)
+{
+    const dynamic_extent e(20, 17, 19);
+    const std::string path = "/codi-test-" + std::to_string(getpid()) + "-" + name;
+    std::unique_ptr<dynamic_network> gathered;
+    std::uint64_t live { 0 };
+    std::vector<std::thread> threads;
+
+    for(int r=0; r<ranks; ++r) {
+        threads.emplace_back([&, r] {
+            try {
+                Transport link(path, r, ranks);
+                distributed_network nw(e, 11, link);
+                grown(nw);
+                steps(nw, 50);
+
+                const std::uint64_t counted = nw.live_cells();
+                std::unique_ptr<dynamic_network> whole = nw.gather();
+                if(r == 0) {
+                    live = counted;
+                    gathered = std::move(whole);
+                }
+            } catch(const std::exception & ex) {
+                std::cerr << name << " rank " << r << ": " << ex.what() << std::endl;
+            }
+        });
+    }
+    for(std::thread & t : threads) {
+        t.join();
+    }
+
+    check(gathered != nullptr, "distributed_network over " + name);
+    if(!gathered) {
+        return;
+    }
+
+    dynamic_network reference(e, 11);
+    grown(reference);
+    steps(reference, 50);
+
+    std::uint64_t reference_live { 0 };
+    for(std::size_t i=0; i<reference.volume(); ++i) {
+        reference_live += (reference.grid.type[i] != BLANK) ? 1 : 0;
+    }
+
+    check_planes(reference, *gathered, "distributed_network over " + name);
+    check(live == reference_live, "distributed_network over " + name + ": live cells");
+}
+
+struct socket_ranks : socket_transport
+{
+    socket_ranks(const std::string & path, const int rank, const int ranks) : socket_transport("/tmp" + path, rank, ranks) { }
+};
+
+struct shm_ranks : shm_transport
+{
+    shm_ranks(const std::string & name, const int rank, const int ranks) : shm_transport(name, rank, ranks, 1 << 16) { }
+};
+
+const test_case distributed("distributed_network", [] {
+    check_distributed<socket_ranks>("socket", 3);
+    check_distributed<shm_ranks>("shm", 2);
+
+    // a segment that is there already is not a new one, rank 0 will not use it
+    const std::string name = "/codi-test-" + std::to_string(getpid()) + "-left-over";
+    shm_transport first(name, 0, 2, 64);
+    bool refused { false };
+    try {
+        shm_transport second(name, 0, 2, 64);
+    } catch(const std::runtime_error &) {
+        refused = true;
+    }
+    check(refused, "shm_transport: left over segment");
+});
+
+}
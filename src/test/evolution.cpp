@@ -0,0 +1,71 @@
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "evolution.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+// neurons that are charged more than half way
+double charged(const dynamic_network & nw)
+{
+    double score { 0 };
+
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        score += (nw.grid.type[i] == NEURON && nw.grid.activation[i] > 16) ? 1 : 0;
+    }
+
+    return score;
+}
+
+evolution_options small_run(const unsigned threads)
+{
+    evolution_options o;
+    o.population = 40;
+    o.signal_steps = 30;
+    o.threads = threads;
+    o.seed = 5;
+    o.mutation_rate = 0.02;
+    return o;
+}
+
+const test_case evolutions("evolution", [] {
+    const dynamic_extent e(14, 12, 8);
+
+    // a run depends on the options only, not on the threads
+    evolution serial(e, charged, small_run(1)), threaded(e, charged, small_run(3));
+    serial.run(3);
+    threaded.run(3);
+
+    bool same { serial.fitnesses() == threaded.fitnesses() };
+    for(std::size_t n=0; n<serial.genomes().size(); ++n) {
+        same = same && serial.genomes()[n] == threaded.genomes()[n];
+    }
+    check(same, "evolution: threads change the run");
+
+    // scores are those of the genome grown and signaled on its own
+    const std::size_t best = serial.best();
+    std::unique_ptr<dynamic_network> nw = serial.genomes()[best].build(small_run(1).seed);
+    grown(*nw);
+    steps(*nw, small_run(1).signal_steps);
+    check(charged(*nw) == serial.fitnesses()[best], "evolution: fitness of the best genome");
+
+    for(const double rate : { -0.1, 1.1, std::numeric_limits<double>::quiet_NaN() }) {
+        evolution_options o = small_run(1);
+        o.mutation_rate = rate;
+
+        bool thrown { false };
+        try {
+            evolution ev(e, charged, o);
+        } catch(const std::invalid_argument &) {
+            thrown = true;
+        }
+        check(thrown, "evolution: a mutation rate of " + std::to_string(rate));
+    }
+});
+
+}
@@ -0,0 +1,99 @@
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "genome.hpp"
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+const dynamic_extent extent(17, 13, 9);
+
+/* No cell breaks the lattice constraints.
+ */
+bool on_lattice(const genome & g)
+{
+    for(int iz=0; iz<extent.z(); ++iz) {
+        for(int iy=0; iy<extent.y(); ++iy) {
+            for(int ix=0; ix<extent.x(); ++ix) {
+                const std::uint8_t c = g.data()[(static_cast<std::size_t>(iz) * extent.y() + iy) * extent.x() + ix];
+                if(dynamic_network::lattice_chromo(c, iz, iy) != c) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename F>
+bool throws(F f)
+{
+    try {
+        f();
+    } catch(const std::exception &) {
+        return true;
+    }
+
+    return false;
+}
+
+
+const test_case genomes("genome", [] {
+    const genome a(extent, 1), b(extent, 2);
+
+    // what a network starts with, and grows the same
+    dynamic_network nw(extent, 1);
+    check(genome(nw) == a, "genome: of a network");
+    {
+        std::unique_ptr<dynamic_network> built = a.build(1);
+        grown(nw);
+        grown(*built);
+        check_planes(nw, *built, "genome: built");
+    }
+
+    // mutation: seeded, none at 0, some at a rate, and on the lattice
+    genome m(a), same(a), none(a);
+    m.mutate(7, 0.05);
+    same.mutate(7, 0.05);
+    none.mutate(7, 0);
+    check(m == same && !(m == a) && none == a, "genome: mutate");
+    check(on_lattice(m), "genome: mutated off the lattice");
+    check(throws([&] { m.mutate(1, -0.5); }) && throws([&] { m.mutate(1, 1.5); })
+          && throws([&] { m.mutate(1, std::numeric_limits<double>::quiet_NaN()); }), "genome: mutate checks the rate");
+
+    // crossover: a prefix of one, the rest of the other
+    const genome child = genome::crossover(a, b, 3);
+    std::size_t cut { 0 };
+    while(cut < child.volume() && child.data()[cut] == a.data()[cut]) {
+        ++cut;
+    }
+    bool rest_of_b { true };
+    for(std::size_t i=cut; i<child.volume(); ++i) {
+        rest_of_b = rest_of_b && child.data()[i] == b.data()[i];
+    }
+    check(rest_of_b && on_lattice(child), "genome: crossover");
+    check(throws([&] { genome::crossover(a, genome(dynamic_extent(3, 3, 3), 1), 1); }), "genome: crossover of other sizes");
+
+    // written and read back, and nothing else read
+    std::stringstream file;
+    m.write(file);
+    check(genome::read(file) == m, "genome: round trip");
+
+    std::string bytes = file.str();
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    check(throws([&] { genome::read(truncated); }), "genome: truncated");
+
+    bytes[0] = 'X';
+    std::istringstream broken(bytes);
+    check(throws([&] { genome::read(broken); }), "genome: not a genome");
+});
+
+}
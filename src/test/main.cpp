@@ -0,0 +1,59 @@
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "test.hpp"
+
+
+namespace
+{
+
+int failures { 0 };
+
+std::map<std::string, void (*)()> & test_cases()
+{
+    static std::map<std::string, void (*)()> cases;
+    return cases;
+}
+
+}
+
+
+test_case::test_case(const std::string & name, void (*run)())
+{
+    test_cases()[name] = run;
+}
+
+void check(const bool ok, const std::string & what)
+{
+    if(!ok) {
+        std::cerr << "FAILED " << what << std::endl;
+        ++failures;
+    }
+}
+
+
+/* make test runs every case, or ./codi-test NAME... only those.
+ */
+int main(int argc, char ** argv)
+{
+    for(const auto & c : test_cases()) {
+        bool wanted = (argc == 1);
+        for(int i=1; i<argc; ++i) {
+            wanted = wanted || (c.first == argv[i]);
+        }
+
+        if(wanted) {
+            std::cout << c.first << std::endl;
+            c.second();
+        }
+    }
+
+    if(failures != 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <string>
+
+#include "network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+const dynamic_extent extent(23, 19, 17);
+
+template <typename Rules>
+std::string name_of(const std::string & what)
+{
+    return what + " " + Rules::name();
+}
+
+
+/* Any number of threads steps the network the serial path does.
+ */
+struct threads_equal_serial
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+
+        for(const unsigned threads : { 2, 3, 5 }) {
+            rules_network a(extent, 3), b(extent, 3);
+            b.set_threads(threads);
+
+            while(a.growing() || b.growing()) {
+                a.step_ca();
+                b.step_ca();
+                check_planes(a, b, name_of<Rules>("threads " + std::to_string(threads) + " growth"));
+            }
+
+            steps(a, 60);
+            steps(b, 60);
+            check_planes(a, b, name_of<Rules>("threads " + std::to_string(threads) + " signaling"));
+        }
+    }
+};
+
+const test_case threads("network threads", [] {
+    threads_equal_serial f;
+    for_each_rules(f);
+});
+
+
+/* The frontier growth engine grows what the full scan does, step by step.
+ */
+struct frontier_equals_full_scan
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+
+        for(const std::uint64_t seed : { 7, 8 }) {
+            rules_network a(extent, seed), b(extent, seed);
+            a.set_growth_engine(growth_engine::FULL_SCAN);
+            b.set_growth_engine(growth_engine::FRONTIER);
+
+            while(a.growing() || b.growing()) {
+                a.step_ca();
+                b.step_ca();
+                check_planes(a, b, name_of<Rules>("frontier growth"));
+            }
+
+            steps(a, 20);
+            steps(b, 20);
+            check_planes(a, b, name_of<Rules>("frontier signaling"));
+        }
+    }
+};
+
+const test_case frontier("network frontier", [] {
+    frontier_equals_full_scan f;
+    for_each_rules(f);
+});
+
+
+
+/* step_ca(n) with k steps fused into a pass is n single steps, with any
+ * number of threads and any n, whole tiles or not.
+ */
+struct tiling_equals_steps
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+
+        for(const int k : { 2, 3, 8 }) {
+            for(const unsigned threads : { 1, 3 }) {
+                rules_network a(extent, 8), b(extent, 8);
+                b.set_temporal_tiling(k);
+                b.set_threads(threads);
+                grown(a);
+                grown(b);
+
+                steps(a, 101);
+                b.step_ca(101);
+                check_planes(a, b, name_of<Rules>("tiling " + std::to_string(k) + " threads " + std::to_string(threads)));
+
+                steps(a, 1);
+                b.step_ca(1);
+                check_planes(a, b, name_of<Rules>("tiling " + std::to_string(k) + " one more step"));
+            }
+
+            // from a new network on, through growth into signaling
+            rules_network a(extent, 9), b(extent, 9);
+            b.set_temporal_tiling(k);
+            steps(a, 150);
+            b.step_ca(150);
+            check_planes(a, b, name_of<Rules>("tiling " + std::to_string(k) + " from growth"));
+        }
+    }
+};
+
+const test_case tiling("network tiling", [] {
+    tiling_equals_steps f;
+    for_each_rules(f);
+});
+
+
+/* reset(seed) is a new network of that seed, whether the old one was
+ * signaling or still growing, and goes on like one.
+ */
+struct reset_equals_new
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+
+        for(const unsigned threads : { 1, 3 }) {
+            for(const int before : { 5, 200 }) {
+                const std::string name = name_of<Rules>("reset after " + std::to_string(before) + " steps, threads " + std::to_string(threads));
+
+                rules_network a(extent, 9), b(extent, 10);
+                b.set_threads(threads);
+                steps(b, before);
+                b.reset(9);
+                check_planes(a, b, name);
+
+                steps(a, 150);
+                steps(b, 150);
+                check_planes(a, b, name + ", stepped");
+            }
+        }
+    }
+};
+
+const test_case reset("network reset", [] {
+    reset_equals_new f;
+    for_each_rules(f);
+});
+
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "network.hpp"
+#include "packed_network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Steps a packed network and a network side by side, stores the packed one
+ * into unpacked every few steps and compares every plane.
+ */
+void check_packed(dynamic_network & reference, packed_network & packed, const std::string & what)
+{
+    dynamic_network unpacked(dynamic_extent(reference.size_x(), reference.size_y(), reference.size_z()), reference.seed());
+
+    for(int s=0; reference.growing() || s < 60; ++s) {
+        reference.step_ca();
+        packed.step_ca();
+
+        if(s % 10 == 0 || !reference.growing()) {
+            packed.store(unpacked);
+            check_planes(reference, unpacked, what + ", step " + std::to_string(s));
+        }
+    }
+
+    packed.store(unpacked);
+    check_planes(reference, unpacked, what);
+}
+
+const test_case packed("packed_network", [] {
+    const dynamic_extent e(21, 18, 16);
+
+    for(const std::uint64_t seed : { 1, 2 }) {
+        dynamic_network reference(e, seed);
+        packed_network packed(e, seed);
+
+        check(packed.bytes() == 3 * packed.volume(), "packed_network: 3 bytes a cell growing");
+        check_packed(reference, packed, "packed_network seed " + std::to_string(seed));
+        check(packed.bytes() == 6 * packed.volume(), "packed_network: 6 bytes a cell signaling");
+    }
+
+    // a chromosome that is not the seed's stays
+    std::vector<std::uint8_t> chromo(e.volume());
+    {
+        const dynamic_network other(e, 9);
+        std::copy_n(other.grid.chromo.data(), e.volume(), chromo.data());
+    }
+
+    dynamic_network reference(e, 3);
+    packed_network packed(e, 3);
+    reference.set_chromo(chromo.data());
+    packed.set_chromo(chromo.data());
+    check_packed(reference, packed, "packed_network set_chromo");
+    check(packed.bytes() == 7 * packed.volume(), "packed_network: 7 bytes a cell signaling with a given chromosome");
+});
+
+}
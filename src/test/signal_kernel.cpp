@@ -0,0 +1,134 @@
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "network.hpp"
+#include "signal_kernel.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Random planes holding every type and gate pair, over n cells.
+ */
+struct kernel_planes
+{
+    std::vector<cell_type> type;
+    std::vector<std::uint8_t> gate;
+    std::vector<std::uint8_t> activation;
+    std::array<std::vector<std::uint8_t>, 6> io;
+
+    kernel_planes(const std::size_t n, std::mt19937 & random) :
+        type(n), gate(n), activation(n)
+    {
+        static const cell_type types[] { BLANK, NEURON, AXON, DENDRITE };
+
+        for(std::size_t i=0; i<n; ++i) {
+            type[i] = types[(i / 6) % 4];
+            gate[i] = i % 6;
+            activation[i] = random();
+        }
+        for(std::vector<std::uint8_t> & lane : io) {
+            lane.resize(n);
+            for(std::uint8_t & v : lane) {
+                // mostly the signals the rules send, now and then anything
+                v = (random() % 8 == 0) ? random() : random() % 3;
+            }
+        }
+    }
+
+    signal_planes planes()
+    {
+        return {
+            type.data(), gate.data(), activation.data(),
+            {{ io[0].data(), io[1].data(), io[2].data(), io[3].data(), io[4].data(), io[5].data() }}
+        };
+    }
+
+    bool operator==(const kernel_planes & other) const
+    {
+        return activation == other.activation && io == other.io;
+    }
+};
+
+template <typename Rules>
+void check_kernel(const signal_kernel k, const std::string & name)
+{
+    std::mt19937 random(1);
+
+    // whole vectors, remainders and cells before the first one
+    for(const std::size_t n : { 1, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 24 * 16 + 5, 24 * 32 + 31, 4099 }) {
+        for(const std::size_t begin : { 0, 1, 7 }) {
+            if(begin > n) {
+                continue;
+            }
+
+            kernel_planes a(n, random);
+            kernel_planes b = a;
+
+            signal_cells_scalar<Rules>(a.planes(), begin, n);
+            signal_cells<Rules>(k, b.planes(), begin, n);
+            check(a == b, name + " " + Rules::name() + " cells [" + std::to_string(begin) + ", " + std::to_string(n) + ")");
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// where each vector kernel leaves the rest to the scalar one
+template <typename Rules>
+void check_remainders()
+{
+    std::mt19937 random(2);
+    kernel_planes p(90, random);
+
+    check(signal_cells_sse2<Rules>(p.planes(), 3, 90) == 83, std::string("sse2 remainder ") + Rules::name());
+    if(__builtin_cpu_supports("avx2")) {
+        check(signal_cells_avx2<Rules>(p.planes(), 3, 90) == 67, std::string("avx2 remainder ") + Rules::name());
+    }
+}
+
+#else
+
+template <typename Rules>
+void check_remainders()
+{
+}
+
+#endif
+
+struct kernels_equal_scalar
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        check_kernel<Rules>(signal_kernel::SSE2, "sse2");
+        if(best_signal_kernel() == signal_kernel::AVX2) {
+            check_kernel<Rules>(signal_kernel::AVX2, "avx2");
+        }
+        check_remainders<Rules>();
+
+        // and a whole network stepped by each
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+        const dynamic_extent e(23, 19, 17);
+
+        rules_network a(e, 5), b(e, 5);
+        a.set_signal_kernel(signal_kernel::SCALAR);
+        b.set_signal_kernel(best_signal_kernel());
+        grown(a);
+        grown(b);
+        steps(a, 100);
+        steps(b, 100);
+        check_planes(a, b, std::string("network kernels ") + Rules::name());
+    }
+};
+
+const test_case signal_kernels("signal_kernel", [] {
+    kernels_equal_scalar f;
+    for_each_rules(f);
+});
+
+}
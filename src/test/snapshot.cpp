@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include "network.hpp"
+#include "snapshot.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Saves nw, maps it back and checks that the loaded network is nw, and
+ * that both go on the same way.
+ */
+void check_round_trip(dynamic_network & nw, const snapshot_options & options, const std::string & what)
+{
+    const std::string path = "/tmp/codi-test-" + std::to_string(getpid()) + ".snap";
+
+    save_snapshot(nw, path, options);
+    {
+        const snapshot_view view(path);
+        check(view.size_x() == nw.size_x() && view.size_y() == nw.size_y() && view.size_z() == nw.size_z(), what + ": size");
+        check(view.seed() == nw.seed() && view.growing() == nw.growing(), what + ": header");
+
+        // compressed planes are not there to read in place, raw ones are the plane
+        const std::uint8_t * type = view.raw_plane(SNAPSHOT_TYPE);
+        const std::uint8_t * own = reinterpret_cast<const std::uint8_t *>(nw.grid.type.data());
+        if(options.compress) {
+            check(type == nullptr, what + ": compressed type plane in place");
+        } else {
+            check(type != nullptr && std::equal(type, type + nw.volume(), own), what + ": raw type plane in place");
+        }
+
+        // without the signaling state the lanes are dropped, signaling clears them anyway
+        std::unique_ptr<dynamic_network> loaded = view.load();
+        if(view.has_signaling_state()) {
+            check_planes(nw, *loaded, what);
+        }
+
+        steps(nw, 40);
+        steps(*loaded, 40);
+        check_planes(nw, *loaded, what + ", stepped on");
+    }
+    std::remove(path.c_str());
+}
+
+const test_case snapshots("snapshot", [] {
+    for(const bool compress : { true, false }) {
+        const std::string name = compress ? "snapshot compressed" : "snapshot raw";
+        const dynamic_extent e(26, 21, 18);
+
+        // still growing, the lanes carry the growth signals
+        dynamic_network growing(e, 4);
+        steps(growing, 3);
+        check_round_trip(growing, snapshot_options(false, compress), name + " growing");
+
+        // signaling, with its state
+        dynamic_network signaling(e, 4);
+        grown(signaling);
+        steps(signaling, 25);
+        check_round_trip(signaling, snapshot_options(true, compress), name + " signaling");
+
+        // grown, without any state to save
+        dynamic_network converged(e, 4);
+        grow(converged);
+        check_round_trip(converged, snapshot_options(false, compress), name + " grown");
+    }
+});
+
+}
@@ -0,0 +1,54 @@
+#include <string>
+
+#include "network.hpp"
+#include "sparse_network.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* Signaling over the live cells gives the activations of signaling in the
+ * grid, stored back into a network grown the same way.
+ */
+struct sparse_equals_dense
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+        const dynamic_extent e(23, 19, 17);
+
+        for(const int n : { 1, 37, 150 }) {
+            rules_network reference(e, 6), stored(e, 6);
+            grown(reference);
+            grown(stored);
+
+            sparse_network<rules_network> sparse(reference);
+            steps(reference, n);
+            for(int s=0; s<n; ++s) {
+                sparse.step();
+            }
+
+            sparse.store(stored);
+            check_activations(reference, stored, std::string("sparse_network ") + Rules::name() + " after " + std::to_string(n));
+        }
+    }
+};
+
+const test_case sparse("sparse_network", [] {
+    sparse_equals_dense f;
+    for_each_rules(f);
+
+    // one cell per live cell of the grid
+    dynamic_network nw(dynamic_extent(16, 16, 16), 2);
+    grown(nw);
+
+    std::size_t live { 0 };
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        live += (nw.grid.type[i] != BLANK) ? 1 : 0;
+    }
+    check(sparse_network<dynamic_network>(nw).cells() == live, "sparse_network: cells");
+});
+
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "network.hpp"
+#include "spike_graph.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+/* The neurons of nw with an activation of 0, the ones that just fired.
+ */
+template <typename Network>
+std::vector<std::uint32_t> fired_in(const Network & nw)
+{
+    std::vector<std::uint32_t> fired;
+
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        if(nw.grid.type[i] == NEURON && nw.grid.activation[i] == 0) {
+            fired.push_back(i);
+        }
+    }
+
+    return fired;
+}
+
+/* The compiled graph fires the neurons signaling in the grid fires, step by
+ * step, and stores back the neuron and dendrite activations; axons are not
+ * tracked and come back as 0.
+ */
+struct spikes_equal_dense
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+        const dynamic_extent e(23, 19, 17);
+        const std::string name = std::string("spike_graph ") + Rules::name();
+
+        rules_network reference(e, 6), stored(e, 6);
+        grown(reference);
+        grown(stored);
+
+        spike_graph<rules_network> spikes(reference);
+        bool same_firings { true };
+        std::size_t firings { 0 };
+
+        for(int s=0; s<150; ++s) {
+            reference.step_ca();
+            spikes.step();
+
+            std::vector<std::uint32_t> fired = spikes.fired();
+            std::sort(fired.begin(), fired.end());
+            same_firings = same_firings && (fired == fired_in(reference));
+            firings += fired.size();
+        }
+        check(same_firings && firings != 0, name + ": fired");
+
+        for(std::size_t i=0; i<reference.volume(); ++i) {
+            if(reference.grid.type[i] == AXON) {
+                reference.grid.activation[i] = 0;
+            }
+        }
+        spikes.store(stored);
+        check_activations(reference, stored, name);
+    }
+};
+
+const test_case spikes("spike_graph", [] {
+    spikes_equal_dense f;
+    for_each_rules(f);
+});
+
+}
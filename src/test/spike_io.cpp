@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "network.hpp"
+#include "spike_io.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+template <typename Network>
+std::vector<std::uint32_t> fired_in(const Network & nw)
+{
+    std::vector<std::uint32_t> fired;
+
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        if(nw.grid.type[i] == NEURON && nw.grid.activation[i] == 0) {
+            fired.push_back(i);
+        }
+    }
+
+    return fired;
+}
+
+template <typename Network>
+std::size_t first_of(const Network & nw, const cell_type type, std::size_t from = 0)
+{
+    while(from < nw.volume() && nw.grid.type[from] != type) {
+        ++from;
+    }
+
+    return from;
+}
+
+/* The strongest signal in any lane of nw.
+ */
+template <typename Network>
+int strongest(const Network & nw)
+{
+    int most { 0 };
+
+    for(int d=0; d<6; ++d) {
+        for(std::size_t i=0; i<nw.volume(); ++i) {
+            most = std::max<int>(most, nw.grid.iobuf[d][i]);
+        }
+    }
+
+    return most;
+}
+
+struct spike_io_checks
+{
+    template <typename Rules>
+    void operator()(Rules)
+    {
+        typedef basic_network<dynamic_extent, Rules> rules_network;
+        const dynamic_extent e(21, 17, 13);
+        const std::string name = std::string("spike_io ") + Rules::name();
+
+        // without inputs the network steps as it would on its own,
+        // and every output neuron with an activation of 0 fired
+        {
+            rules_network nw(e, 3), reference(e, 3);
+            grown(nw);
+            grown(reference);
+
+            spike_io<rules_network> io(nw);
+            io.add_output_region(0, 0, 0, e.z(), e.y(), e.x());
+
+            bool same { true };
+            std::size_t events { 0 };
+            for(int s=0; s<60; ++s) {
+                io.step();
+                reference.step_ca();
+
+                std::vector<std::uint32_t> fired;
+                spike_event ev;
+                while(io.outputs().pop(ev)) {
+                    same = same && ev.step == static_cast<std::uint64_t>(s);
+                    fired.push_back(io.output_cell(ev.neuron));
+                }
+                std::sort(fired.begin(), fired.end());
+                same = same && fired == fired_in(reference);
+                events += fired.size();
+            }
+            check(same && events != 0, name + ": outputs");
+            check_planes(reference, nw, name + ": without inputs");
+        }
+
+        // the strongest inputs make a neuron fire, and no lane carry more than the rules send
+        {
+            rules_network nw(e, 4);
+            grown(nw);
+
+            spike_io<rules_network> io(nw);
+            const std::size_t neuron = first_of(nw, NEURON);
+            const std::size_t axon = first_of(nw, AXON);
+            const std::size_t dendrite = first_of(nw, DENDRITE);
+            io.add_input(neuron);
+            io.add_input(axon);
+            io.add_input(dendrite);
+            io.add_output(neuron);
+
+            bool bounded { true };
+            bool fired_when_driven { true };
+            for(std::uint64_t s=0; s<40; ++s) {
+                for(std::uint32_t input=0; input<3; ++input) {
+                    io.inputs().push(spike_input { s, input, 255 });
+                }
+                io.step();
+
+                spike_event ev;
+                fired_when_driven = fired_when_driven && io.outputs().pop(ev) && ev.step == s;
+                bounded = bounded && strongest(nw) <= Rules::most_signal;
+            }
+            check(fired_when_driven, name + ": a driven neuron fires every step");
+            check(bounded, name + ": injected signals stay in range");
+        }
+
+        // first in, first out: a later input holds back an earlier one behind it
+        {
+            rules_network nw(e, 5);
+            grown(nw);
+
+            spike_io<rules_network> io(nw);
+            io.add_input(first_of(nw, NEURON));
+            io.inputs().push(spike_input { 3, 0, 1 });
+            io.inputs().push(spike_input { 1, 0, 1 });
+
+            bool held { true };
+            for(int s=0; s<3; ++s) {
+                io.step();
+                held = held && io.inputs().front() != nullptr && io.inputs().front()->step == 3;
+            }
+            io.step();
+            check(held && io.inputs().front() == nullptr, name + ": inputs in order");
+        }
+    }
+};
+
+const test_case spike_ios("spike_io", [] {
+    spike_io_checks f;
+    for_each_rules(f);
+
+    dynamic_network nw(dynamic_extent(8, 8, 8), 1);
+    grown(nw);
+    spike_io<dynamic_network> io(nw);
+
+    bool thrown { false };
+    try {
+        io.add_input(nw.volume());
+    } catch(const std::invalid_argument &) {
+        thrown = true;
+    }
+    check(thrown, "spike_io: an input outside the grid");
+});
+
+}
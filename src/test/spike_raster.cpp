@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "network.hpp"
+#include "spike_raster.hpp"
+#include "test.hpp"
+
+
+namespace
+{
+
+typedef std::map<std::uint64_t, std::vector<std::uint32_t>> raster;
+
+/* The cells a recording of that kind holds for nw as it is.
+ */
+std::vector<std::uint32_t> cells_of(const dynamic_network & nw, const raster_kind kind)
+{
+    std::vector<std::uint32_t> cells;
+
+    for(std::size_t i=0; i<nw.volume(); ++i) {
+        const bool on = nw.grid.activation[i] != 0;
+        const bool active = (kind == RASTER_FIRINGS) ? nw.grid.type[i] == NEURON && !on
+                                                     : nw.grid.type[i] != BLANK && (nw.grid.type[i] == NEURON) != on;
+        if(active) {
+            cells.push_back(i);
+        }
+    }
+
+    return cells;
+}
+
+raster read_back(const std::string & path, const std::uint64_t begin, const std::uint64_t end)
+{
+    raster steps;
+    raster_reader reader(path);
+
+    reader.read(begin, end, [&](const std::uint64_t step, const std::vector<std::uint32_t> & cells) {
+        steps[step] = cells;
+    });
+    return steps;
+}
+
+/* The steps of all with begin <= step < end.
+ */
+raster between(const raster & all, const std::uint64_t begin, const std::uint64_t end)
+{
+    return raster(all.lower_bound(begin), all.lower_bound(end));
+}
+
+void check_recording(const raster_kind kind, const unsigned long every, const std::string & what)
+{
+    const std::string path = "/tmp/codi-test-" + std::to_string(getpid()) + ".raster";
+    const int n { 200 };
+
+    // what the recording has to hold, recorded steps counted from 1
+    dynamic_network nw(dynamic_extent(22, 19, 15), 13);
+    grown(nw);
+    raster expected;
+    {
+        raster_recorder recorder(path, nw.size_x(), nw.size_y(), nw.size_z(), kind, every, 16);
+        for(int s=1; s<=n; ++s) {
+            nw.step_ca();
+            recorder.record(nw);
+            if(s % every == 0) {
+                expected[s] = cells_of(nw, kind);
+            }
+        }
+        recorder.finish();
+    }
+
+    std::uint64_t index_offset { 0 };
+    {
+        raster_reader reader(path);
+        check(reader.kind() == kind && reader.every() == every, what + ": header");
+        check(reader.size_x() == nw.size_x() && reader.size_y() == nw.size_y() && reader.size_z() == nw.size_z(), what + ": size");
+        check(reader.chunks().size() == (n / every + 15) / 16, what + ": chunks");
+
+        const raster_chunk & last = reader.chunks().back();
+        index_offset = last.offset + last.bytes;
+    }
+
+    check(read_back(path, 0, n + 1) == expected, what);
+    check(read_back(path, 37, 151) == between(expected, 37, 151), what + ", steps 37 to 150");
+
+    // without its index, all the chunks are still there
+    check(truncate(path.c_str(), index_offset) == 0, what + ": cut off the index");
+    check(read_back(path, 0, n + 1) == expected, what + ", no index");
+
+    // a chunk cut off is dropped, the ones before it are read
+    check(truncate(path.c_str(), index_offset - 1) == 0, what + ": cut off the last chunk");
+    std::uint64_t full_chunks_end { 0 };
+    {
+        raster_reader reader(path);
+        const raster_chunk & last = reader.chunks().back();
+        full_chunks_end = last.first_step + last.steps * every;
+    }
+    check(full_chunks_end <= static_cast<std::uint64_t>(n) && read_back(path, 0, n + 1) == between(expected, 0, full_chunks_end), what + ", last chunk cut off");
+
+    std::remove(path.c_str());
+}
+
+const test_case rasters("spike_raster", [] {
+    for(const unsigned long every : { 1, 3 }) {
+        check_recording(RASTER_FIRINGS, every, "spike_raster firings every " + std::to_string(every));
+        check_recording(RASTER_ACTIVITY, every, "spike_raster activity every " + std::to_string(every));
+    }
+});
+
+}
@@ -0,0 +1,133 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include "cell_rules.hpp"
+
+
+/* What make test runs: one file per header under test, each registers its
+ * cases with a static test_case, and main runs them all by name.
+ */
+struct test_case
+{
+    test_case(const std::string & name, void (*run)());
+};
+
+/* A failed check prints what failed and fails make test, the case goes on.
+ */
+void check(const bool ok, const std::string & what);
+
+
+/* Calls f(Rules()) for every rule set compiled in, see cell_rules.hpp.
+ */
+template <typename F>
+void for_each_rules(F & f)
+{
+    const std::string names = compiled_rules::names();
+
+    for(std::size_t begin=0; begin<=names.size(); ) {
+        const std::size_t end = std::min(names.find('|', begin), names.size());
+        const std::string name = names.substr(begin, end - begin);
+
+        check(compiled_rules::dispatch(name, f), "no rules called " + name);
+        begin = end + 1;
+    }
+}
+
+
+/* The first cell where a and b differ in plane(nw, iz, iy, ix),
+ * as " at x,y,z", or "" if they do not.
+ */
+template <typename Network, typename Plane>
+std::string first_difference(const Network & a, const Network & b, Plane plane)
+{
+    for(int iz=0; iz<a.size_z(); ++iz) {
+        for(int iy=0; iy<a.size_y(); ++iy) {
+            for(int ix=0; ix<a.size_x(); ++ix) {
+                if(plane(a, iz, iy, ix) != plane(b, iz, iy, ix)) {
+                    std::ostringstream at;
+                    at << " at " << ix << ',' << iy << ',' << iz;
+                    return at.str();
+                }
+            }
+        }
+    }
+
+    return "";
+}
+
+template <typename Network>
+void check_activations(const Network & a, const Network & b, const std::string & what)
+{
+    const std::string at = first_difference(a, b, [](const Network & nw, int iz, int iy, int ix) -> int {
+        return nw.activation(iz, iy, ix);
+    });
+    check(at.empty(), what + ": activation" + at);
+}
+
+/* Every plane of two networks, the lanes included.
+ */
+template <typename Network>
+void check_planes(const Network & a, const Network & b, const std::string & what)
+{
+    check(a.size_x() == b.size_x() && a.size_y() == b.size_y() && a.size_z() == b.size_z(), what + ": size");
+    if(a.size_x() != b.size_x() || a.size_y() != b.size_y() || a.size_z() != b.size_z()) {
+        return;
+    }
+    check(a.growing() == b.growing(), what + ": growing");
+
+    std::string at = first_difference(a, b, [](const Network & nw, int iz, int iy, int ix) -> int {
+        return nw.type(iz, iy, ix);
+    });
+    check(at.empty(), what + ": type" + at);
+
+    at = first_difference(a, b, [](const Network & nw, int iz, int iy, int ix) -> int {
+        return nw.gate(iz, iy, ix);
+    });
+    check(at.empty(), what + ": gate" + at);
+
+    at = first_difference(a, b, [](const Network & nw, int iz, int iy, int ix) -> int {
+        return nw.chromo(iz, iy, ix);
+    });
+    check(at.empty(), what + ": chromo" + at);
+
+    check_activations(a, b, what);
+
+    for(int d=0; d<6; ++d) {
+        at = first_difference(a, b, [d](const Network & nw, int iz, int iy, int ix) -> int {
+            return nw.iobuf(d, iz, iy, ix);
+        });
+        check(at.empty(), what + ": iobuf " + std::to_string(d) + at);
+    }
+}
+
+
+template <typename Network>
+void grow(Network & nw)
+{
+    while(nw.growing()) {
+        nw.step_ca();
+    }
+}
+
+/* Grown until it converges and set up for signaling.
+ */
+template <typename Network>
+void grown(Network & nw)
+{
+    grow(nw);
+    nw.prepare_signaling();
+}
+
+template <typename Network>
+void steps(Network & nw, const int n)
+{
+    for(int s=0; s<n; ++s) {
+        nw.step_ca();
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include <array>
+#include <cstdint>
+#include <thread>
+
+#include "test.hpp"
+#include "triple_buffer.hpp"
+
+
+namespace
+{
+
+const test_case buffers("triple_buffer", [] {
+    // one thread: the consumer gets the latest value, the ones before it are dropped
+    triple_buffer<int> b;
+    check(b.front() == nullptr && !b.update(), "triple_buffer: nothing before the first publish");
+
+    b.back() = 1;
+    b.publish();
+    b.back() = 2;
+    b.publish();
+    check(b.update() && *b.front() == 2, "triple_buffer: latest value");
+    check(!b.update() && *b.front() == 2, "triple_buffer: nothing newer");
+
+    b.back() = 3;
+    b.publish();
+    check(b.update() && *b.front() == 3, "triple_buffer: next value");
+
+    // two threads: whole values, in order, the last one always arrives
+    typedef std::array<std::uint32_t, 64> value;
+    const std::uint32_t last { 200000 };
+    triple_buffer<value> shared;
+
+    std::thread producer([&] {
+        for(std::uint32_t n=1; n<=last; ++n) {
+            shared.back().fill(n);
+            shared.publish();
+        }
+    });
+
+    bool whole { true }, ordered { true };
+    std::uint32_t seen { 0 };
+    while(seen != last) {
+        if(!shared.update()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const value & v = *shared.front();
+        for(const std::uint32_t x : v) {
+            whole = whole && (x == v[0]);
+        }
+        ordered = ordered && (v[0] > seen);
+        seen = v[0];
+    }
+    producer.join();
+
+    check(whole, "triple_buffer: torn value");
+    check(ordered, "triple_buffer: values out of order");
+});
+
+}
@@ -0,0 +1,78 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+
+
+/* Hands the latest of a stream of values from exactly one producer thread
+ * to exactly one consumer thread without either ever waiting:
+ * the producer fills back() and publish()es it, the consumer takes
+ * the latest published value with update() and reads it in front()
+ * until its next update(). Values the consumer was too slow for are dropped.
+ *
+ * Three slots, one owned by each side and one in the middle; publish()
+ * and update() swap their own slot with the middle one.
+ */
+template <typename T>
+class triple_buffer
+{
+private:
+    static constexpr unsigned FRESH = 4;
+
+    std::array<T, 3> slots;
+    unsigned back_slot;
+    unsigned front_slot;
+    bool any;
+
+    // the slot in the middle, | FRESH if the producer published it since the consumer last took it
+    std::atomic<unsigned> middle;
+
+public:
+    triple_buffer() :
+        back_slot(0),
+        front_slot(1),
+        any(false),
+        middle(2)
+    {
+    }
+
+    triple_buffer(const triple_buffer &) = delete;
+    triple_buffer & operator=(const triple_buffer &) = delete;
+
+    /* Producer side: the slot to fill, it keeps what was last written into it.
+     */
+    inline T & back()
+    {
+        return slots[back_slot];
+    }
+
+    /* Producer side.
+     */
+    inline void publish()
+    {
+        back_slot = middle.exchange(back_slot | FRESH, std::memory_order_acq_rel) & 3;
+    }
+
+    /* Consumer side: takes the latest published value, false if there is none newer than front().
+     */
+    inline bool update()
+    {
+        if(!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+
+        front_slot = middle.exchange(front_slot, std::memory_order_acq_rel) & 3;
+        any = true;
+        return true;
+    }
+
+    /* Consumer side: the value update() took last, nullptr before the first one.
+     */
+    inline const T * front() const
+    {
+        return any ? &slots[front_slot] : nullptr;
+    }
+};
+
+#endif
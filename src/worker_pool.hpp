@@ -0,0 +1,115 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/* A fixed set of threads that run one job at a time.
+ * run() splits [0, count) into one contiguous chunk per worker,
+ * runs chunk 0 on the calling thread and returns once every chunk is done,
+ * so the end of run() is the only synchronisation point.
+ */
+class worker_pool
+{
+public:
+    typedef std::function<void(unsigned worker, std::size_t begin, std::size_t end)> job_type;
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    job_type job;
+    std::size_t count;
+    unsigned long generation;
+    unsigned pending;
+    bool stopping;
+
+
+    inline std::size_t chunk_begin(const unsigned worker) const
+    {
+        return count * worker / size();
+    }
+
+    void worker_loop(const unsigned worker)
+    {
+        unsigned long seen { 0 };
+
+        for(;;) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+
+            if(stopping) {
+                return;
+            }
+
+            seen = generation;
+            lock.unlock();
+
+            job(worker, chunk_begin(worker), chunk_begin(worker + 1));
+
+            lock.lock();
+            if(--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit worker_pool(const unsigned workers) :
+        count(0),
+        generation(0),
+        pending(0),
+        stopping(false)
+    {
+        for(unsigned w=1; w<workers; ++w) {
+            threads.emplace_back(&worker_pool::worker_loop, this, w);
+        }
+    }
+
+    ~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_all();
+        for(std::thread & t : threads) {
+            t.join();
+        }
+    }
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool & operator=(const worker_pool &) = delete;
+
+    inline unsigned size() const
+    {
+        return threads.size() + 1;
+    }
+
+    void run(const std::size_t n, job_type j)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = std::move(j);
+            count = n;
+            pending = threads.size();
+            ++generation;
+        }
+
+        wake.notify_all();
+        job(0, chunk_begin(0), chunk_begin(1));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+#endif